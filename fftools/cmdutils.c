@@ -138,6 +138,9 @@ void exit_program(int ret)
     if (program_exit)
         program_exit(ret);
 
+    /* print what is still queued */
+    av_log_set_flags(av_log_get_flags() & ~AV_LOG_ASYNC);
+
     exit(ret);
 }
 
@@ -912,6 +915,13 @@ int opt_loglevel(void *optctx, const char *opt, const char *arg)
                 flags |= AV_LOG_PRINT_LEVEL;
             }
             arg = token + 5;
+        } else if (!strncmp(token, "async", 5)) {
+            if (cmd == '-') {
+                flags &= ~AV_LOG_ASYNC;
+            } else {
+                flags |= AV_LOG_ASYNC;
+            }
+            arg = token + 5;
         } else {
             break;
         }
@@ -63,6 +63,7 @@
 #include "libavutil/time.h"
 #include "libavutil/thread.h"
 #include "libavutil/threadmessage.h"
+#include "libavutil/trace.h"
 #include "libavcodec/mathops.h"
 #include "libavformat/os_support.h"
 
@@ -141,6 +142,8 @@ static int want_sdp = 1;
 
 static BenchmarkTimeStamps current_time;
 AVIOContext *progress_avio = NULL;
+AVIOContext *trace_avio = NULL;
+static int64_t last_trace_flush;
 
 static uint8_t *subtitle_out;
 
@@ -480,6 +483,29 @@ static int decode_interrupt_cb(void *ctx)
 
 const AVIOInterruptCB int_cb = { decode_interrupt_cb, NULL };
 
+static void flush_trace(int64_t cur_time, int is_last)
+{
+    AVBPrint buf;
+    int ret;
+
+    if (!trace_avio || (!is_last && cur_time - last_trace_flush < 100000))
+        return;
+    last_trace_flush = cur_time;
+
+    av_bprint_init(&buf, 0, AV_BPRINT_SIZE_UNLIMITED);
+    ret = av_trace_flush(&buf);
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_WARNING, "Dropping trace events: %s\n", av_err2str(ret));
+        av_bprint_clear(&buf);
+    }
+    if (is_last)
+        av_bprintf(&buf, "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\","
+                         "\"args\":{\"name\":\"%s\"}}\n]\n", program_name);
+    avio_write(trace_avio, buf.str, FFMIN(buf.len, buf.size - 1));
+    avio_flush(trace_avio);
+    av_bprint_finalize(&buf, NULL);
+}
+
 static void ffmpeg_cleanup(int ret)
 {
     int i, j;
@@ -614,6 +640,14 @@ static void ffmpeg_cleanup(int ret)
     }
     av_freep(&vstats_filename);
 
+    if (trace_avio) {
+        av_trace_stop();
+        flush_trace(av_gettime_relative(), 1);
+        if (avio_closep(&trace_avio) < 0)
+            av_log(NULL, AV_LOG_ERROR,
+                   "Error closing trace file, loss of information possible\n");
+    }
+
     av_freep(&input_streams);
     av_freep(&input_files);
     av_freep(&output_streams);
@@ -1530,6 +1564,44 @@ static int reap_filters(int flush)
     return 0;
 }
 
+static void print_filter_stats(void)
+{
+    int i, j, k;
+
+    for (i = 0; i < nb_filtergraphs; i++) {
+        AVFilterGraph *graph = filtergraphs[i]->graph;
+        int64_t total = 0;
+
+        if (!graph)
+            continue;
+        for (j = 0; j < graph->nb_filters; j++)
+            total += graph->filters[j]->activation_time;
+
+        av_log(NULL, AV_LOG_INFO, "Filtergraph #%d: %.3fs\n", i, total / 1000000.0);
+        for (j = 0; j < graph->nb_filters; j++) {
+            AVFilterContext *filter = graph->filters[j];
+
+            av_log(NULL, AV_LOG_INFO, "  %-32s %8"PRId64" activations %10.3fms %5.1f%%\n",
+                   filter->name, filter->nb_activations,
+                   filter->activation_time / 1000.0,
+                   total ? 100.0 * filter->activation_time / total : 0.0);
+            for (k = 0; k < filter->nb_outputs; k++) {
+                AVFilterLink *link = filter->outputs[k];
+
+                if (!link)
+                    continue;
+                av_log(NULL, AV_LOG_INFO, "    -> %s:%-*s %8"PRId64" frames, queued max %"PRId64
+                       " avg %.2f, max %"PRId64" bytes\n",
+                       link->dst->name, FFMAX(28 - (int)strlen(link->dst->name), 0),
+                       avfilter_pad_get_name(link->dstpad, 0),
+                       link->frame_count_in, link->max_queued_frames,
+                       link->frame_count_in ? (double)link->queued_frames_sum / link->frame_count_in : 0.0,
+                       link->max_queued_bytes);
+            }
+        }
+    }
+}
+
 static void print_final_stats(int64_t total_size)
 {
     uint64_t video_size = 0, audio_size = 0, extra_size = 0, other_size = 0;
@@ -4684,6 +4756,7 @@ static int transcode(void)
 
         /* dump report by using the output first video and audio streams */
         print_report(0, timer_start, cur_time);
+        flush_trace(cur_time, 0);
     }
 #if HAVE_THREADS
     free_input_threads();
@@ -4720,6 +4793,9 @@ static int transcode(void)
     /* dump report by using the first video and audio streams */
     print_report(1, timer_start, av_gettime_relative());
 
+    if (do_filter_stats)
+        print_filter_stats();
+
     /* close each encoder */
     for (i = 0; i < nb_output_streams; i++) {
         ost = output_streams[i];
@@ -590,6 +590,7 @@ extern int video_sync_method;
 extern float frame_drop_threshold;
 extern int do_benchmark;
 extern int do_benchmark_all;
+extern int do_filter_stats;
 extern int do_deinterlace;
 extern int do_hex_dump;
 extern int do_pkt_dump;
@@ -604,6 +605,7 @@ extern int qp_hist;
 extern int stdin_interaction;
 extern int frame_bits_per_raw_sample;
 extern AVIOContext *progress_avio;
+extern AVIOContext *trace_avio;
 extern float max_error_rate;
 extern char *videotoolbox_pixfmt;
 
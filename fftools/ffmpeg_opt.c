@@ -40,6 +40,7 @@
 #include "libavutil/parseutils.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/pixfmt.h"
+#include "libavutil/trace.h"
 
 #define DEFAULT_PASS_LOGFILENAME_PREFIX "ffmpeg2pass"
 
@@ -94,6 +95,7 @@ float frame_drop_threshold = 0;
 int do_deinterlace    = 0;
 int do_benchmark      = 0;
 int do_benchmark_all  = 0;
+int do_filter_stats   = 0;
 int do_hex_dump       = 0;
 int do_pkt_dump       = 0;
 int copy_ts           = 0;
@@ -3304,6 +3306,32 @@ static int opt_progress(void *optctx, const char *opt, const char *arg)
     return 0;
 }
 
+static int opt_trace_file(void *optctx, const char *opt, const char *arg)
+{
+    AVIOContext *avio = NULL;
+    int ret;
+
+    if (trace_avio) {
+        av_log(NULL, AV_LOG_ERROR, "Only one trace file can be specified\n");
+        return AVERROR(EINVAL);
+    }
+    ret = avio_open2(&avio, arg, AVIO_FLAG_WRITE, &int_cb, NULL);
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Failed to open trace file \"%s\": %s\n",
+               arg, av_err2str(ret));
+        return ret;
+    }
+    ret = av_trace_start();
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Could not start tracing: %s\n", av_err2str(ret));
+        avio_closep(&avio);
+        return ret;
+    }
+    avio_printf(avio, "[\n");
+    trace_avio = avio;
+    return 0;
+}
+
 #define OFFSET(x) offsetof(OptionsContext, x)
 const OptionDef options[] = {
     /* main options */
@@ -3380,8 +3408,12 @@ const OptionDef options[] = {
         "add timings for benchmarking" },
     { "benchmark_all",  OPT_BOOL | OPT_EXPERT,                       { &do_benchmark_all },
       "add timings for each task" },
+    { "filter_stats",   OPT_BOOL | OPT_EXPERT,                       { &do_filter_stats },
+      "print processing time and queue statistics for each filter" },
     { "progress",       HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_progress },
       "write program-readable progress information", "url" },
+    { "trace_file",     HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_trace_file },
+      "write timing spans of the processing steps in Chrome trace format", "url" },
     { "stdin",          OPT_BOOL | OPT_EXPERT,                       { &stdin_interaction },
       "enable or disable interaction on standard input" },
     { "timelimit",      HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_timelimit },
@@ -1312,6 +1312,7 @@ static void do_exit(VideoState *is)
         printf("\n");
     SDL_Quit();
     av_log(NULL, AV_LOG_QUIET, "%s", "");
+    av_log_set_flags(av_log_get_flags() & ~AV_LOG_ASYNC);
     exit(0);
 }
 
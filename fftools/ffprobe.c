@@ -3694,5 +3694,7 @@ end:
 
     avformat_network_deinit();
 
+    av_log_set_flags(av_log_get_flags() & ~AV_LOG_ASYNC);
+
     return ret < 0;
 }
@@ -3302,6 +3302,21 @@ typedef struct AVCodecContext {
      * used as reference pictures).
      */
     int extra_hw_frames;
+
+    /**
+     * Account charged with the buffers allocated by the codec, such as
+     * frame and packet data, see AVBufferAccount. When its limit is reached,
+     * encoding and decoding fail with AVERROR(ENOMEM).
+     *
+     * If unset, the buffers are charged to the account current in the
+     * calling thread, if any.
+     *
+     * - encoding: May be set by the user before avcodec_open2(), owned by
+     *             the user.
+     * - decoding: May be set by the user before avcodec_open2(), owned by
+     *             the user.
+     */
+    AVBufferAccount *buffer_account;
 } AVCodecContext;
 
 #if FF_API_CODEC_GET_SET
@@ -37,6 +37,7 @@
 #include "libavutil/internal.h"
 #include "libavutil/intmath.h"
 #include "libavutil/opt.h"
+#include "libavutil/trace.h"
 
 #include "avcodec.h"
 #include "bytestream.h"
@@ -706,7 +707,11 @@ int attribute_align_arg avcodec_send_packet(AVCodecContext *avctx, const AVPacke
     }
 
     if (!avci->buffer_frame->buf[0]) {
+        AVBufferAccount *prev_account = av_buffer_account_enter(avctx->buffer_account);
+        av_trace_begin("avcodec_send_packet", avctx->codec->name);
         ret = decode_receive_frame_internal(avctx, avci->buffer_frame);
+        av_trace_end();
+        av_buffer_account_leave(prev_account);
         if (ret < 0 && ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
             return ret;
     }
@@ -754,7 +759,11 @@ int attribute_align_arg avcodec_receive_frame(AVCodecContext *avctx, AVFrame *fr
     if (avci->buffer_frame->buf[0]) {
         av_frame_move_ref(frame, avci->buffer_frame);
     } else {
+        AVBufferAccount *prev_account = av_buffer_account_enter(avctx->buffer_account);
+        av_trace_begin("avcodec_receive_frame", avctx->codec->name);
         ret = decode_receive_frame_internal(avctx, frame);
+        av_trace_end();
+        av_buffer_account_leave(prev_account);
         if (ret < 0)
             return ret;
     }
@@ -75,6 +75,7 @@ typedef struct DNXHDEncContext {
     int intra_quant_bias;
 
     DECLARE_ALIGNED(32, int16_t, blocks)[12][64];
+    DECLARE_ALIGNED(32, int16_t, coefs)[12][64]; ///< transformed blocks, reused for every qscale
     DECLARE_ALIGNED(16, uint8_t, edge_buf_y)[512]; // has to hold 16x16 uint16 when depth=10
     DECLARE_ALIGNED(16, uint8_t, edge_buf_uv)[2][512]; // has to hold 16x16 uint16_t when depth=10
 
@@ -94,6 +95,7 @@ typedef struct DNXHDEncContext {
     /** Rate control */
     unsigned slice_bits;
     unsigned qscale;
+    unsigned qscale_last; ///< last qscale evaluated by one rate control pass
     unsigned lambda;
 
     uint16_t *mb_bits;
@@ -103,6 +105,13 @@ typedef struct DNXHDEncContext {
     RCCMPEntry *mb_cmp_tmp;
     RCEntry    *mb_rc;
 
+    /**
+     * Quantize a block already transformed by fdsp.fdct, or NULL if the
+     * transform cannot be split from dct_quantize.
+     */
+    int (*quantize)(MpegEncContext *s, int16_t *block,
+                    int n, int qscale, int *overflow);
+
     void (*get_pixels_8x4_sym)(int16_t *av_restrict /* align 16 */ block,
                                const uint8_t *pixels, ptrdiff_t line_size);
 } DNXHDEncContext;
@@ -24,6 +24,7 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/internal.h"
 #include "libavutil/samplefmt.h"
+#include "libavutil/trace.h"
 
 #include "avcodec.h"
 #include "frame_thread_encoder.h"
@@ -385,6 +386,9 @@ static int do_encode(AVCodecContext *avctx, const AVFrame *frame, int *got_packe
 
 int attribute_align_arg avcodec_send_frame(AVCodecContext *avctx, const AVFrame *frame)
 {
+    AVBufferAccount *prev_account;
+    int ret;
+
     if (!avcodec_is_open(avctx) || !av_codec_is_encoder(avctx->codec))
         return AVERROR(EINVAL);
 
@@ -398,19 +402,25 @@ int attribute_align_arg avcodec_send_frame(AVCodecContext *avctx, const AVFrame
             return 0;
     }
 
-    if (avctx->codec->send_frame)
-        return avctx->codec->send_frame(avctx, frame);
-
-    // Emulation via old API. Do it here instead of avcodec_receive_packet, because:
+    // Without send_frame, emulate via old API. Do it here instead of
+    // avcodec_receive_packet, because:
     // 1. if the AVFrame is not refcounted, the copying will be much more
     //    expensive than copying the packet data
     // 2. assume few users use non-refcounted AVPackets, so usually no copy is
     //    needed
 
-    if (avctx->internal->buffer_pkt_valid)
-        return AVERROR(EAGAIN);
+    prev_account = av_buffer_account_enter(avctx->buffer_account);
+    av_trace_begin("avcodec_send_frame", avctx->codec->name);
+    if (avctx->codec->send_frame)
+        ret = avctx->codec->send_frame(avctx, frame);
+    else if (avctx->internal->buffer_pkt_valid)
+        ret = AVERROR(EAGAIN);
+    else
+        ret = do_encode(avctx, frame, &(int){0});
+    av_trace_end();
+    av_buffer_account_leave(prev_account);
 
-    return do_encode(avctx, frame, &(int){0});
+    return ret;
 }
 
 int attribute_align_arg avcodec_receive_packet(AVCodecContext *avctx, AVPacket *avpkt)
@@ -421,19 +431,31 @@ int attribute_align_arg avcodec_receive_packet(AVCodecContext *avctx, AVPacket *
         return AVERROR(EINVAL);
 
     if (avctx->codec->receive_packet) {
+        AVBufferAccount *prev_account;
+        int ret;
         if (avctx->internal->draining && !(avctx->codec->capabilities & AV_CODEC_CAP_DELAY))
             return AVERROR_EOF;
-        return avctx->codec->receive_packet(avctx, avpkt);
+        prev_account = av_buffer_account_enter(avctx->buffer_account);
+        av_trace_begin("avcodec_receive_packet", avctx->codec->name);
+        ret = avctx->codec->receive_packet(avctx, avpkt);
+        av_trace_end();
+        av_buffer_account_leave(prev_account);
+        return ret;
     }
 
     // Emulation via old API.
 
     if (!avctx->internal->buffer_pkt_valid) {
+        AVBufferAccount *prev_account;
         int got_packet;
         int ret;
         if (!avctx->internal->draining)
             return AVERROR(EAGAIN);
+        prev_account = av_buffer_account_enter(avctx->buffer_account);
+        av_trace_begin("avcodec_receive_packet", avctx->codec->name);
         ret = do_encode(avctx, NULL, &got_packet);
+        av_trace_end();
+        av_buffer_account_leave(prev_account);
         if (ret < 0)
             return ret;
         if (ret >= 0 && !got_packet)
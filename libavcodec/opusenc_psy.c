@@ -395,19 +395,44 @@ static void celt_search_for_dual_stereo(OpusPsyContext *s, CeltFrame *f)
     s->dual_stereo_used += td2 < td1;
 }
 
+typedef struct IntensityThreadData {
+    OpusPsyContext *s;
+    const CeltFrame *f;
+    float dist[CELT_MAX_BANDS + 1];
+} IntensityThreadData;
+
+/* Each candidate band runs on a private copy of the frame and PVQ state,
+ * so the candidates can be evaluated in any order and on any thread. */
+static int intensity_dist_thread(AVCodecContext *avctx, void *arg,
+                                 int jobnr, int threadnr)
+{
+    IntensityThreadData *td = arg;
+    OpusPsyContext *s = td->s;
+    CeltFrame *f = &s->thread_frame[threadnr];
+
+    memcpy(f, td->f, sizeof(*f));
+    f->pvq = s->thread_pvq[threadnr];
+    f->intensity_stereo = td->f->end_band - jobnr;
+
+    return bands_dist(s, f, &td->dist[jobnr]);
+}
+
 static void celt_search_for_intensity(OpusPsyContext *s, CeltFrame *f)
 {
     int i, best_band = CELT_MAX_BANDS - 1;
-    float dist, best_dist = FLT_MAX;
+    float best_dist = FLT_MAX;
     /* TODO: fix, make some heuristic up here using the lambda value */
-    float end_band = 0;
+    int end_band = 0;
+    IntensityThreadData td = { .s = s, .f = f };
 
     if (s->avctx->channels < 2)
         return;
 
+    s->avctx->execute2(s->avctx, intensity_dist_thread, &td, NULL,
+                       f->end_band - end_band + 1);
+
     for (i = f->end_band; i >= end_band; i--) {
-        f->intensity_stereo = i;
-        bands_dist(s, f, &dist);
+        float dist = td.dist[f->end_band - i];
         if (best_dist > dist) {
             best_dist = dist;
             best_band = i;
@@ -540,6 +565,17 @@ av_cold int ff_opus_psy_init(OpusPsyContext *s, AVCodecContext *avctx,
         goto fail;
     }
 
+    s->nb_threads   = FFMAX(avctx->thread_count, 1);
+    s->thread_frame = av_malloc_array(s->nb_threads, sizeof(*s->thread_frame));
+    s->thread_pvq   = av_mallocz_array(s->nb_threads, sizeof(*s->thread_pvq));
+    if (!s->thread_frame || !s->thread_pvq) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    for (i = 0; i < s->nb_threads; i++)
+        if ((ret = ff_celt_pvq_init(&s->thread_pvq[i], 1)) < 0)
+            goto fail;
+
     for (ch = 0; ch < s->avctx->channels; ch++) {
         for (i = 0; i < CELT_MAX_BANDS; i++) {
             bessel_init(&s->bfilter_hi[ch][i], 1.0f, 19.0f, 100.0f, 1);
@@ -574,6 +610,12 @@ fail:
     av_freep(&s->inflection_points);
     av_freep(&s->dsp);
 
+    if (s->thread_pvq)
+        for (i = 0; i < s->nb_threads; i++)
+            ff_celt_pvq_uninit(&s->thread_pvq[i]);
+    av_freep(&s->thread_pvq);
+    av_freep(&s->thread_frame);
+
     for (i = 0; i < CELT_BLOCK_NB; i++) {
         ff_mdct15_uninit(&s->mdct[i]);
         av_freep(&s->window[i]);
@@ -597,6 +639,12 @@ av_cold int ff_opus_psy_end(OpusPsyContext *s)
     av_freep(&s->inflection_points);
     av_freep(&s->dsp);
 
+    if (s->thread_pvq)
+        for (i = 0; i < s->nb_threads; i++)
+            ff_celt_pvq_uninit(&s->thread_pvq[i]);
+    av_freep(&s->thread_pvq);
+    av_freep(&s->thread_frame);
+
     for (i = 0; i < CELT_BLOCK_NB; i++) {
         ff_mdct15_uninit(&s->mdct[i]);
         av_freep(&s->window[i]);
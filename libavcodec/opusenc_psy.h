@@ -73,6 +73,11 @@ typedef struct OpusPsyContext {
 
     DECLARE_ALIGNED(32, float, scratch)[2048];
 
+    /* Per-thread state for the parallel intensity stereo search */
+    CeltFrame *thread_frame;
+    CeltPVQ  **thread_pvq;
+    int nb_threads;
+
     /* Stats */
     float rc_waste;
     float avg_is_band;
@@ -400,6 +400,23 @@ static inline void encode_vlc_codeword(PutBitContext *pb, unsigned codebook, int
 #define GET_SIGN(x)  ((x) >> 31)
 #define MAKE_CODE(x) ((((x)) * 2) ^ GET_SIGN(x))
 
+/**
+ * Reciprocal of a quantiser for use with quant_div().
+ */
+static inline uint64_t quant_recip(int quant)
+{
+    return UINT64_C(0xFFFFFFFF) / quant + 1;
+}
+
+/**
+ * Divide a non-negative coefficient by a quantiser through its reciprocal.
+ * The result is exact for values below 1 << 16, which covers all DCT output.
+ */
+static inline int quant_div(int val, uint64_t recip)
+{
+    return (val * recip) >> 32;
+}
+
 static void encode_dcs(PutBitContext *pb, int16_t *blocks,
                        int blocks_per_slice, int scale)
 {
@@ -441,10 +458,11 @@ static void encode_acs(PutBitContext *pb, int16_t *blocks,
     run        = 0;
 
     for (i = 1; i < 64; i++) {
+        const uint64_t recip = quant_recip(qmat[scan[i]]);
         for (idx = scan[i]; idx < max_coeffs; idx += 64) {
-            level = blocks[idx] / qmat[scan[i]];
-            if (level) {
-                abs_level = FFABS(level);
+            level     = blocks[idx];
+            abs_level = quant_div(FFABS(level), recip);
+            if (abs_level) {
                 encode_vlc_codeword(pb, ff_prores_ac_codebook[run_cb], run);
                 encode_vlc_codeword(pb, ff_prores_ac_codebook[lev_cb],
                                     abs_level - 1);
@@ -702,11 +720,13 @@ static int estimate_acs(int *error, int16_t *blocks, int blocks_per_slice,
     run        = 0;
 
     for (i = 1; i < 64; i++) {
+        const int      quant = qmat[scan[i]];
+        const uint64_t recip = quant_recip(quant);
         for (idx = scan[i]; idx < max_coeffs; idx += 64) {
-            level   = blocks[idx] / qmat[scan[i]];
-            *error += FFABS(blocks[idx]) % qmat[scan[i]];
-            if (level) {
-                abs_level = FFABS(level);
+            level     = FFABS(blocks[idx]);
+            abs_level = quant_div(level, recip);
+            *error   += level - abs_level * quant;
+            if (abs_level) {
                 bits += estimate_vlc(ff_prores_ac_codebook[run_cb], run);
                 bits += estimate_vlc(ff_prores_ac_codebook[lev_cb],
                                      abs_level - 1) + 1;
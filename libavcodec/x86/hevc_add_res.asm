@@ -367,3 +367,43 @@ cglobal hevc_add_residual_32_10, 3, 5, 6
     jg .loop
     RET
 %endif ;HAVE_AVX2_EXTERNAL
+
+%if HAVE_AVX512_EXTERNAL
+; one 32-pixel row per zmm register; neither the residual nor the picture
+; rows are guaranteed to be 64-byte aligned
+%macro ADD_RES_AVX512_32_10 4
+    movu              m0, [%4]
+    movu              m1, [%4+64]
+    movu              m2, [%4+128]
+    movu              m3, [%4+192]
+
+    paddw             m0, [%1]
+    paddw             m1, [%1+%2]
+    paddw             m2, [%1+%2*2]
+    paddw             m3, [%1+%3]
+
+    CLIPW             m0, m4, m5
+    CLIPW             m1, m4, m5
+    CLIPW             m2, m4, m5
+    CLIPW             m3, m4, m5
+    movu            [%1], m0
+    movu         [%1+%2], m1
+    movu       [%1+%2*2], m2
+    movu         [%1+%3], m3
+%endmacro
+
+INIT_ZMM avx512
+cglobal hevc_add_residual_32_10, 3, 5, 6
+    pxor               m4, m4
+    vpbroadcastw       m5, [max_pixels_10]
+    lea                r3, [r2*3]
+
+    mov               r4d, 8
+.loop:
+    ADD_RES_AVX512_32_10 r0, r2, r3, r1
+    lea                r0, [r0+r2*4]
+    add                r1, 256
+    dec               r4d
+    jg .loop
+    RET
+%endif ;HAVE_AVX512_EXTERNAL
@@ -264,6 +264,33 @@ cglobal hevc_idct_%1x%1_dc_%3, 1, 2, 1, coeff, tmp
     RET
 %endmacro
 
+; the coefficient buffers are only guaranteed to be 32-byte aligned,
+; so use unaligned stores for the zmm version
+; %1 = bitdepth
+%macro IDCT_DC_32x32_AVX512 1
+cglobal hevc_idct_32x32_dc_%1, 1, 2, 1, coeff, tmp
+    movsx             tmpd, word [coeffq]
+    add               tmpd, (1 << (14 - %1)) + 1
+    sar               tmpd, (15 - %1)
+    movd               xm0, tmpd
+    SPLATW              m0, xm0
+    DEFINE_ARGS coeff, cnt
+    mov               cntd, 4
+.loop:
+    movu [coeffq+mmsize*0], m0
+    movu [coeffq+mmsize*1], m0
+    movu [coeffq+mmsize*2], m0
+    movu [coeffq+mmsize*3], m0
+    add  coeffq, mmsize*8
+    movu [coeffq+mmsize*-4], m0
+    movu [coeffq+mmsize*-3], m0
+    movu [coeffq+mmsize*-2], m0
+    movu [coeffq+mmsize*-1], m0
+    dec  cntd
+    jg  .loop
+    RET
+%endmacro
+
 ; %1 = HxW
 ; %2 = bitdepth
 %macro IDCT_DC_NL 2 ; No loop
@@ -823,6 +850,11 @@ IDCT_DC    32, 16,  %1
     IDCT_DC    16,  2,  %1
     IDCT_DC    32,  8,  %1
 %endif ;HAVE_AVX2_EXTERNAL
+
+%if HAVE_AVX512_EXTERNAL
+    INIT_ZMM avx512
+    IDCT_DC_32x32_AVX512 %1
+%endif ;HAVE_AVX512_EXTERNAL
 %endmacro
 
 %macro INIT_IDCT 2
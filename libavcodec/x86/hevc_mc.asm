@@ -1669,4 +1669,44 @@ HEVC_PUT_HEVC_QPEL 16, 10
 HEVC_PUT_HEVC_QPEL_HV 16, 10
 
 %endif ;AVX2
+
+%if HAVE_AVX512_EXTERNAL
+; a 64-pixel 10-bit row is exactly two zmm registers; the intermediate and
+; picture buffers are not 64-byte aligned, so only unaligned accesses are used
+INIT_ZMM avx512
+cglobal hevc_put_hevc_pel_pixels64_10, 4, 4, 2, dst, src, srcstride, height
+.loop:
+    movu              m0, [srcq]
+    movu              m1, [srcq+mmsize]
+    psllw             m0, 14-10
+    psllw             m1, 14-10
+    movu           [dstq], m0
+    movu    [dstq+mmsize], m1
+    LOOP_END         dst, src, srcstride
+    RET
+
+cglobal hevc_put_hevc_bi_pel_pixels64_10, 6, 6, 5, dst, dststride, src, srcstride, src2, height
+    pxor              m2, m2
+    vpbroadcastw      m3, [max_pixels_10]
+    vpbroadcastw      m4, [pw_bi_10]
+.loop:
+    movu              m0, [srcq]
+    movu              m1, [srcq+mmsize]
+    psllw             m0, 14-10
+    psllw             m1, 14-10
+    paddsw            m0, [src2q]
+    paddsw            m1, [src2q+mmsize]
+    pmulhrsw          m0, m4
+    pmulhrsw          m1, m4
+    CLIPW             m0, m2, m3
+    CLIPW             m1, m2, m3
+    movu           [dstq], m0
+    movu    [dstq+mmsize], m1
+    add             dstq, dststrideq             ; dst += dststride
+    add             srcq, srcstrideq             ; src += srcstride
+    add            src2q, 2*MAX_PB_SIZE          ; src += srcstride
+    dec          heightd                         ; cmp height
+    jnz               .loop                      ; height loop
+    RET
+%endif ;AVX512
 %endif ; ARCH_X86_64
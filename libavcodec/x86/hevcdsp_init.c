@@ -70,6 +70,7 @@ IDCT_DC_FUNCS(16x16, sse2);
 IDCT_DC_FUNCS(32x32, sse2);
 IDCT_DC_FUNCS(16x16, avx2);
 IDCT_DC_FUNCS(32x32, avx2);
+IDCT_DC_FUNCS(32x32, avx512);
 
 #define IDCT_FUNCS(opt)                                             \
 void ff_hevc_idct_4x4_8_    ## opt(int16_t *coeffs, int col_limit); \
@@ -877,6 +878,9 @@ void ff_hevc_dsp_init_x86(HEVCDSPContext *c, const int bit_depth)
 
             c->add_residual[3] = ff_hevc_add_residual_32_8_avx2;
         }
+        if (EXTERNAL_AVX512(cpu_flags)) {
+            c->idct_dc[3] = ff_hevc_idct_32x32_dc_8_avx512;
+        }
     } else if (bit_depth == 10) {
         if (EXTERNAL_MMXEXT(cpu_flags)) {
             c->add_residual[0] = ff_hevc_add_residual_4_10_mmxext;
@@ -1094,6 +1098,17 @@ void ff_hevc_dsp_init_x86(HEVCDSPContext *c, const int bit_depth)
             c->add_residual[2] = ff_hevc_add_residual_16_10_avx2;
             c->add_residual[3] = ff_hevc_add_residual_32_10_avx2;
         }
+        if (EXTERNAL_AVX512(cpu_flags)) {
+            c->idct_dc[3] = ff_hevc_idct_32x32_dc_10_avx512;
+            if (ARCH_X86_64) {
+                c->put_hevc_epel[9][0][0]    = ff_hevc_put_hevc_pel_pixels64_10_avx512;
+                c->put_hevc_qpel[9][0][0]    = ff_hevc_put_hevc_pel_pixels64_10_avx512;
+                c->put_hevc_epel_bi[9][0][0] = ff_hevc_put_hevc_bi_pel_pixels64_10_avx512;
+                c->put_hevc_qpel_bi[9][0][0] = ff_hevc_put_hevc_bi_pel_pixels64_10_avx512;
+            }
+
+            c->add_residual[3] = ff_hevc_add_residual_32_10_avx512;
+        }
     } else if (bit_depth == 12) {
         if (EXTERNAL_MMXEXT(cpu_flags)) {
             c->idct_dc[0] = ff_hevc_idct_4x4_dc_12_mmxext;
@@ -1147,5 +1162,8 @@ void ff_hevc_dsp_init_x86(HEVCDSPContext *c, const int bit_depth)
             SAO_BAND_INIT(12, avx2);
             SAO_EDGE_INIT(12, avx2);
         }
+        if (EXTERNAL_AVX512(cpu_flags)) {
+            c->idct_dc[3] = ff_hevc_idct_32x32_dc_12_avx512;
+        }
     }
 }
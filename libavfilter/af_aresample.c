@@ -200,7 +200,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamplesref)
         return AVERROR(ENOMEM);
     }
 
-    av_frame_copy_props(outsamplesref, insamplesref);
+    av_frame_copy_props_shared(outsamplesref, insamplesref);
     outsamplesref->format                = outlink->format;
     outsamplesref->channels              = outlink->channels;
     outsamplesref->channel_layout        = outlink->channel_layout;
@@ -33,6 +33,8 @@
 #include "libavutil/rational.h"
 #include "libavutil/samplefmt.h"
 #include "libavutil/thread.h"
+#include "libavutil/time.h"
+#include "libavutil/trace.h"
 
 #define FF_INTERNAL_FIELDS 1
 #include "framequeue.h"
@@ -1120,6 +1122,11 @@ int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
         av_frame_free(&frame);
         return ret;
     }
+    link->queued_frames_sum += ff_framequeue_queued_frames(&link->fifo);
+    link->max_queued_frames  = FFMAX(link->max_queued_frames,
+                                     ff_framequeue_queued_frames(&link->fifo));
+    link->max_queued_bytes   = FFMAX(link->max_queued_bytes,
+                                     ff_framequeue_queued_bytes(&link->fifo));
     ff_filter_set_ready(link->dst, 300);
     return 0;
 
@@ -1420,14 +1427,23 @@ static int ff_filter_activate_default(AVFilterContext *filter)
 
 int ff_filter_activate(AVFilterContext *filter)
 {
+    int64_t start = filter->graph->collect_stats ? av_gettime_relative() : 0;
+    AVBufferAccount *prev_account;
     int ret;
 
     /* Generic timeline support is not yet implemented but should be easy */
     av_assert1(!(filter->filter->flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC &&
                  filter->filter->activate));
     filter->ready = 0;
+    prev_account = av_buffer_account_enter(filter->graph->buffer_account);
+    av_trace_begin("ff_filter_activate", filter->filter->name);
     ret = filter->filter->activate ? filter->filter->activate(filter) :
           ff_filter_activate_default(filter);
+    av_trace_end();
+    av_buffer_account_leave(prev_account);
+    if (filter->graph->collect_stats)
+        filter->activation_time += av_gettime_relative() - start;
+    filter->nb_activations++;
     if (ret == FFERROR_NOT_READY)
         ret = 0;
     return ret;
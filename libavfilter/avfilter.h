@@ -422,6 +422,16 @@ struct AVFilterContext {
      * configured.
      */
     int extra_hw_frames;
+
+    /**
+     * Number of times the filter was activated, and wall clock time spent
+     * in these activations, in microseconds. This includes the callbacks of
+     * its pads and the time spent waiting for its slice threads.
+     *
+     * The time is only measured if AVFilterGraph.collect_stats is set.
+     */
+    int64_t nb_activations;
+    int64_t activation_time;
 };
 
 /**
@@ -600,6 +610,17 @@ struct AVFilterLink {
      */
     AVBufferRef *hw_frames_ctx;
 
+    /**
+     * Statistics about the frames waiting on the link to be filtered,
+     * updated each time a frame is sent through the link: the highest number
+     * of queued frames, the sum of the number of queued frames (divided by
+     * frame_count_in, it gives the average queue depth) and the highest
+     * total size in bytes of the buffers referenced by the queued frames.
+     */
+    int64_t max_queued_frames;
+    int64_t queued_frames_sum;
+    int64_t max_queued_bytes;
+
 #ifndef FF_INTERNAL_FIELDS
 
     /**
@@ -896,6 +917,25 @@ typedef struct AVFilterGraph {
 
     char *aresample_swr_opts; ///< swr options to use for the auto-inserted aresample filters, Access ONLY through AVOptions
 
+    /**
+     * Account charged with the buffers allocated by the filters of the graph
+     * while they are processing frames, see AVBufferAccount. When its limit
+     * is reached, filtering fails with AVERROR(ENOMEM).
+     *
+     * If unset, the buffers are charged to the account current in the
+     * calling thread, if any.
+     *
+     * Set and owned by the user.
+     */
+    AVBufferAccount *buffer_account;
+
+    /**
+     * If set, measure the time spent in each filter, see
+     * AVFilterContext.activation_time. May be set by the caller at any time,
+     * directly or through the "stats" option.
+     */
+    int collect_stats;
+
     /**
      * Private fields
      *
@@ -56,6 +56,8 @@ static const AVOption filtergraph_options[] = {
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, F|V },
     {"aresample_swr_opts"   , "default aresample filter options"    , OFFSET(aresample_swr_opts)    ,
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, F|A },
+    { "stats",       "Measure the time spent in each filter", OFFSET(collect_stats),
+        AV_OPT_TYPE_BOOL,  { .i64 = 0 }, 0, 1, F|V|A },
     { NULL },
 };
 
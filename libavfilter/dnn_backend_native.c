@@ -27,6 +27,7 @@
 #include "dnn_srcnn.h"
 #include "dnn_espcn.h"
 #include "libavformat/avio.h"
+#include "internal.h"
 
 typedef enum {INPUT, CONV, DEPTH_TO_SPACE} LayerType;
 
@@ -41,6 +42,7 @@ typedef struct Layer{
 typedef struct ConvolutionalParams{
     int32_t input_num, output_num, kernel_size;
     ActivationFunc activation;
+    // stored as [input_num][kernel_size][kernel_size][output_num]
     float *kernel;
     float *biases;
 } ConvolutionalParams;
@@ -57,8 +59,41 @@ typedef struct DepthToSpaceParams{
 typedef struct ConvolutionalNetwork{
     Layer *layers;
     int32_t layers_num;
+    // Each layer only reads the output of the previous one, so the outputs
+    // of all layers but the input one alternate between these two buffers.
+    float *buffers[2];
 } ConvolutionalNetwork;
 
+// Reorders kernel from the [output_num][kernel_size][kernel_size][input_num]
+// layout of the model to the one used by convolve().
+static int reorder_kernel(ConvolutionalParams *conv_params)
+{
+    int n_filter, ch, kernel_y, kernel_x;
+    int size = conv_params->kernel_size;
+    int filter_linesize = size * conv_params->input_num;
+    int filter_size = size * filter_linesize;
+    float *kernel = av_malloc_array(conv_params->output_num, filter_size * sizeof(*kernel));
+
+    if (!kernel){
+        return DNN_ERROR;
+    }
+    for (n_filter = 0; n_filter < conv_params->output_num; ++n_filter){
+        for (ch = 0; ch < conv_params->input_num; ++ch){
+            for (kernel_y = 0; kernel_y < size; ++kernel_y){
+                for (kernel_x = 0; kernel_x < size; ++kernel_x){
+                    kernel[((ch * size + kernel_y) * size + kernel_x) * conv_params->output_num + n_filter] =
+                        conv_params->kernel[n_filter * filter_size + kernel_y * filter_linesize +
+                                            kernel_x * conv_params->input_num + ch];
+                }
+            }
+        }
+    }
+    av_free(conv_params->kernel);
+    conv_params->kernel = kernel;
+
+    return DNN_SUCCESS;
+}
+
 static DNNReturnType set_input_output_native(void *model, DNNData *input, DNNData *output)
 {
     ConvolutionalNetwork *network = (ConvolutionalNetwork *)model;
@@ -66,6 +101,7 @@ static DNNReturnType set_input_output_native(void *model, DNNData *input, DNNDat
     ConvolutionalParams *conv_params;
     DepthToSpaceParams *depth_to_space_params;
     int cur_width, cur_height, cur_channels;
+    size_t buffer_size[2] = { 0 };
     int32_t layer;
 
     if (network->layers_num <= 0 || network->layers[0].type != INPUT){
@@ -106,14 +142,21 @@ static DNNReturnType set_input_output_native(void *model, DNNData *input, DNNDat
         default:
             return DNN_ERROR;
         }
-        if (network->layers[layer].output){
-            av_freep(&network->layers[layer].output);
-        }
-        network->layers[layer].output = av_malloc(cur_height * cur_width * cur_channels * sizeof(float));
-        if (!network->layers[layer].output){
-            return DNN_ERROR;
+        buffer_size[layer & 1] = FFMAX(buffer_size[layer & 1], (size_t)cur_height * cur_width * cur_channels);
+    }
+
+    for (layer = 0; layer < 2; ++layer){
+        av_freep(&network->buffers[layer]);
+        if (buffer_size[layer]){
+            network->buffers[layer] = av_malloc_array(buffer_size[layer], sizeof(float));
+            if (!network->buffers[layer]){
+                return DNN_ERROR;
+            }
         }
     }
+    for (layer = 1; layer < network->layers_num; ++layer){
+        network->layers[layer].output = network->buffers[layer & 1];
+    }
 
     output->data = network->layers[network->layers_num - 1].output;
     output->height = cur_height;
@@ -138,7 +181,7 @@ DNNModel *ff_dnn_load_model_native(const char *model_filename)
     ConvolutionalParams *conv_params;
     DepthToSpaceParams *depth_to_space_params;
 
-    model = av_malloc(sizeof(DNNModel));
+    model = av_mallocz(sizeof(DNNModel));
     if (!model){
         return NULL;
     }
@@ -149,7 +192,7 @@ DNNModel *ff_dnn_load_model_native(const char *model_filename)
     }
     file_size = avio_size(model_file_context);
 
-    network = av_malloc(sizeof(ConvolutionalNetwork));
+    network = av_mallocz(sizeof(ConvolutionalNetwork));
     if (!network){
         avio_closep(&model_file_context);
         av_freep(&model);
@@ -219,6 +262,11 @@ DNNModel *ff_dnn_load_model_native(const char *model_filename)
             }
             network->layers[layer].type = CONV;
             network->layers[layer].params = conv_params;
+            if (reorder_kernel(conv_params) != DNN_SUCCESS){
+                avio_closep(&model_file_context);
+                ff_dnn_free_model_native(&model);
+                return NULL;
+            }
             break;
         case DEPTH_TO_SPACE:
             depth_to_space_params = av_malloc(sizeof(DepthToSpaceParams));
@@ -276,6 +324,12 @@ static int set_up_conv_layer(Layer *layer, const float *kernel, const float *bia
     }
     memcpy(conv_params->kernel, kernel, kernel_size * sizeof(float));
     memcpy(conv_params->biases, biases, output_num * sizeof(float));
+    if (reorder_kernel(conv_params) != DNN_SUCCESS){
+        av_freep(&conv_params->kernel);
+        av_freep(&conv_params->biases);
+        av_freep(&conv_params);
+        return DNN_ERROR;
+    }
     layer->type = CONV;
     layer->params = conv_params;
 
@@ -289,12 +343,12 @@ DNNModel *ff_dnn_load_default_model_native(DNNDefaultModel model_type)
     DepthToSpaceParams *depth_to_space_params;
     int32_t layer;
 
-    model = av_malloc(sizeof(DNNModel));
+    model = av_mallocz(sizeof(DNNModel));
     if (!model){
         return NULL;
     }
 
-    network = av_malloc(sizeof(ConvolutionalNetwork));
+    network = av_mallocz(sizeof(ConvolutionalNetwork));
     if (!network){
         av_freep(&model);
         return NULL;
@@ -365,28 +419,38 @@ DNNModel *ff_dnn_load_default_model_native(DNNDefaultModel model_type)
 
 #define CLAMP_TO_EDGE(x, w) ((x) < 0 ? 0 : ((x) >= (w) ? (w - 1) : (x)))
 
-static void convolve(const float *input, float *output, const ConvolutionalParams *conv_params, int width, int height)
+static void convolve(const float *input, float *output, const ConvolutionalParams *conv_params,
+                     int width, int height, int slice_start, int slice_end)
 {
     int y, x, n_filter, ch, kernel_y, kernel_x;
     int radius = conv_params->kernel_size >> 1;
     int src_linesize = width * conv_params->input_num;
-    int filter_linesize = conv_params->kernel_size * conv_params->input_num;
-    int filter_size = conv_params->kernel_size * filter_linesize;
+    int output_num = conv_params->output_num;
 
-    for (y = 0; y < height; ++y){
+    output += slice_start * width * output_num;
+    for (y = slice_start; y < slice_end; ++y){
         for (x = 0; x < width; ++x){
-            for (n_filter = 0; n_filter < conv_params->output_num; ++n_filter){
+            const float *kernel = conv_params->kernel;
+
+            for (n_filter = 0; n_filter < output_num; ++n_filter){
                 output[n_filter] = conv_params->biases[n_filter];
-                for (ch = 0; ch < conv_params->input_num; ++ch){
-                    for (kernel_y = 0; kernel_y < conv_params->kernel_size; ++kernel_y){
-                        for (kernel_x = 0; kernel_x < conv_params->kernel_size; ++kernel_x){
-                            output[n_filter] += input[CLAMP_TO_EDGE(y + kernel_y - radius, height) * src_linesize +
-                                                      CLAMP_TO_EDGE(x + kernel_x - radius, width) * conv_params->input_num + ch] *
-                                                conv_params->kernel[n_filter * filter_size + kernel_y * filter_linesize +
-                                                                    kernel_x * conv_params->input_num + ch];
+            }
+            // Accumulate in the same order as a plain per-filter loop over
+            // channels and taps, but with the filters innermost, so that
+            // the results do not change and the inner loop can be vectorized.
+            for (ch = 0; ch < conv_params->input_num; ++ch){
+                for (kernel_y = 0; kernel_y < conv_params->kernel_size; ++kernel_y){
+                    const float *src = input + CLAMP_TO_EDGE(y + kernel_y - radius, height) * src_linesize + ch;
+                    for (kernel_x = 0; kernel_x < conv_params->kernel_size; ++kernel_x){
+                        const float value = src[CLAMP_TO_EDGE(x + kernel_x - radius, width) * conv_params->input_num];
+                        for (n_filter = 0; n_filter < output_num; ++n_filter){
+                            output[n_filter] += value * kernel[n_filter];
                         }
+                        kernel += output_num;
                     }
                 }
+            }
+            for (n_filter = 0; n_filter < output_num; ++n_filter){
                 switch (conv_params->activation){
                 case RELU:
                     output[n_filter] = FFMAX(output[n_filter], 0.0);
@@ -398,14 +462,32 @@ static void convolve(const float *input, float *output, const ConvolutionalParam
                     output[n_filter] = 1.0f / (1.0f + exp(-output[n_filter]));
                 }
             }
-            output += conv_params->output_num;
+            output += output_num;
         }
     }
 }
 
+typedef struct ThreadData{
+    const float *input;
+    float *output;
+    const ConvolutionalParams *conv_params;
+    int width, height;
+} ThreadData;
+
+static int convolve_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    const ThreadData *td = arg;
+    const int slice_start = (td->height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (td->height * (jobnr + 1)) / nb_jobs;
+
+    convolve(td->input, td->output, td->conv_params, td->width, td->height, slice_start, slice_end);
+
+    return 0;
+}
+
 static void depth_to_space(const float *input, float *output, int block_size, int width, int height, int channels)
 {
-    int y, x, by, bx, ch;
+    int y, x, by;
     int new_channels = channels / (block_size * block_size);
     int output_linesize = width * channels;
     int by_linesize = output_linesize / block_size;
@@ -414,12 +496,8 @@ static void depth_to_space(const float *input, float *output, int block_size, in
     for (y = 0; y < height; ++y){
         for (x = 0; x < width; ++x){
             for (by = 0; by < block_size; ++by){
-                for (bx = 0; bx < block_size; ++bx){
-                    for (ch = 0; ch < new_channels; ++ch){
-                        output[by * by_linesize + x * x_linesize + bx * new_channels + ch] = input[ch];
-                    }
-                    input += new_channels;
-                }
+                memcpy(output + by * by_linesize + x * x_linesize, input, x_linesize * sizeof(*input));
+                input += x_linesize;
             }
         }
         output += output_linesize;
@@ -429,11 +507,13 @@ static void depth_to_space(const float *input, float *output, int block_size, in
 DNNReturnType ff_dnn_execute_model_native(const DNNModel *model)
 {
     ConvolutionalNetwork *network = (ConvolutionalNetwork *)model->model;
+    AVFilterContext *ctx = model->filter_ctx;
     int cur_width, cur_height, cur_channels;
     int32_t layer;
     InputParams *input_params;
     ConvolutionalParams *conv_params;
     DepthToSpaceParams *depth_to_space_params;
+    ThreadData td;
 
     if (network->layers_num <= 0 || network->layers[0].type != INPUT || !network->layers[0].output){
         return DNN_ERROR;
@@ -452,7 +532,19 @@ DNNReturnType ff_dnn_execute_model_native(const DNNModel *model)
         switch (network->layers[layer].type){
         case CONV:
             conv_params = (ConvolutionalParams *)network->layers[layer].params;
-            convolve(network->layers[layer - 1].output, network->layers[layer].output, conv_params, cur_width, cur_height);
+            if (ctx){
+                td.input = network->layers[layer - 1].output;
+                td.output = network->layers[layer].output;
+                td.conv_params = conv_params;
+                td.width = cur_width;
+                td.height = cur_height;
+                ctx->internal->execute(ctx, convolve_slice, &td, NULL,
+                                       FFMIN(cur_height, ff_filter_get_nb_threads(ctx)));
+            }
+            else{
+                convolve(network->layers[layer - 1].output, network->layers[layer].output, conv_params,
+                         cur_width, cur_height, 0, cur_height);
+            }
             cur_channels = conv_params->output_num;
             break;
         case DEPTH_TO_SPACE:
@@ -480,8 +572,10 @@ void ff_dnn_free_model_native(DNNModel **model)
     if (*model)
     {
         network = (ConvolutionalNetwork *)(*model)->model;
+        av_freep(&network->layers[0].output);
+        av_freep(&network->buffers[0]);
+        av_freep(&network->buffers[1]);
         for (layer = 0; layer < network->layers_num; ++layer){
-            av_freep(&network->layers[layer].output);
             if (network->layers[layer].type == CONV){
                 conv_params = (ConvolutionalParams *)network->layers[layer].params;
                 av_freep(&conv_params->kernel);
@@ -163,7 +163,7 @@ DNNModel *ff_dnn_load_model_tf(const char *model_filename)
     TF_Buffer *graph_def;
     TF_ImportGraphDefOptions *graph_opts;
 
-    model = av_malloc(sizeof(DNNModel));
+    model = av_mallocz(sizeof(DNNModel));
     if (!model){
         return NULL;
     }
@@ -443,7 +443,7 @@ DNNModel *ff_dnn_load_default_model_tf(DNNDefaultModel model_type)
 
     input.index = 0;
 
-    model = av_malloc(sizeof(DNNModel));
+    model = av_mallocz(sizeof(DNNModel));
     if (!model){
         return NULL;
     }
@@ -43,6 +43,9 @@ typedef struct DNNModel{
     // Sets model input and output, while allocating additional memory for intermediate calculations.
     // Should be called at least once before model execution.
     DNNReturnType (*set_input_output)(void *model, DNNData *input, DNNData *output);
+    // Filter context whose execute callback may be used to run the model in
+    // parallel slices. Optional, set by the filter after loading the model.
+    struct AVFilterContext *filter_ctx;
 } DNNModel;
 
 // Stores pointers to functions for loading, executing, freeing DNN models for one of the backends.
@@ -619,6 +619,35 @@ static void blend_line_hv(uint8_t *dst, int dst_delta,
                     right, hband, hsub + vsub, xm);
 }
 
+/* Fast paths for an 8 bits per pixel mask on a plane without subsampling:
+   each destination pixel maps to exactly one mask pixel, so there is nothing
+   to accumulate and the loops are simple enough to be vectorized. */
+static void blend_line_mask(uint8_t *dst, int dst_delta,
+                            unsigned src, unsigned alpha,
+                            const uint8_t *mask, int w)
+{
+    int x;
+
+    for (x = 0; x < w; x++) {
+        unsigned a = mask[x] * alpha;
+        *dst = ((0x1010101 - a) * *dst + a * src) >> 24;
+        dst += dst_delta;
+    }
+}
+
+static void blend_line_mask16(uint8_t *dst, int dst_delta,
+                              unsigned src, unsigned alpha,
+                              const uint8_t *mask, int w)
+{
+    int x;
+
+    for (x = 0; x < w; x++) {
+        unsigned a = mask[x] * alpha;
+        AV_WL16(dst, ((0x10001 - a) * AV_RL16(dst) + a * src) >> 16);
+        dst += dst_delta;
+    }
+}
+
 void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
                    uint8_t *dst[], int dst_linesize[], int dst_w, int dst_h,
                    const uint8_t *mask,  int mask_linesize, int mask_w, int mask_h,
@@ -659,6 +688,21 @@ void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
                 continue;
             p = p0 + comp;
             m = mask;
+            if (l2depth == 3 && !draw->hsub[plane] && !draw->vsub[plane]) {
+                for (y = 0; y < h_sub; y++) {
+                    if (depth <= 8)
+                        blend_line_mask(p, draw->pixelstep[plane],
+                                        color->comp[plane].u8[comp], alpha,
+                                        m + xm0, w_sub);
+                    else
+                        blend_line_mask16(p, draw->pixelstep[plane],
+                                          color->comp[plane].u16[comp], alpha,
+                                          m + xm0, w_sub);
+                    p += dst_linesize[plane];
+                    m += mask_linesize;
+                }
+                continue;
+            }
             if (top) {
                 if (depth <= 8) {
                     blend_line_hv(p, draw->pixelstep[plane],
@@ -99,9 +99,10 @@ typedef struct EBUR128Context {
     double *sample_peaks;           ///< sample peaks per channel
     double *true_peaks_per_frame;   ///< true peaks in a frame per channel
 #if CONFIG_SWRESAMPLE
-    SwrContext *swr_ctx;            ///< over-sampling context for true peak metering
+    SwrContext **swr_ctx;           ///< per-channel over-sampling contexts for true peak metering
     double *swr_buf;                ///< resampled audio data for true peak metering
     int swr_linesize;
+    int swr_channel[MAX_CHANNELS];  ///< input channel picked by each over-sampling context
 #endif
 
     /* video  */
@@ -409,22 +410,38 @@ static int config_audio_output(AVFilterLink *outlink)
         ebur128->swr_buf    = av_malloc_array(nb_channels, 19200 * sizeof(double));
         ebur128->true_peaks = av_calloc(nb_channels, sizeof(*ebur128->true_peaks));
         ebur128->true_peaks_per_frame = av_calloc(nb_channels, sizeof(*ebur128->true_peaks_per_frame));
-        ebur128->swr_ctx    = swr_alloc();
+        ebur128->swr_ctx    = av_calloc(nb_channels, sizeof(*ebur128->swr_ctx));
         if (!ebur128->swr_buf || !ebur128->true_peaks ||
             !ebur128->true_peaks_per_frame || !ebur128->swr_ctx)
             return AVERROR(ENOMEM);
 
-        av_opt_set_int(ebur128->swr_ctx, "in_channel_layout",    outlink->channel_layout, 0);
-        av_opt_set_int(ebur128->swr_ctx, "in_sample_rate",       outlink->sample_rate, 0);
-        av_opt_set_sample_fmt(ebur128->swr_ctx, "in_sample_fmt", outlink->format, 0);
-
-        av_opt_set_int(ebur128->swr_ctx, "out_channel_layout",    outlink->channel_layout, 0);
-        av_opt_set_int(ebur128->swr_ctx, "out_sample_rate",       192000, 0);
-        av_opt_set_sample_fmt(ebur128->swr_ctx, "out_sample_fmt", outlink->format, 0);
-
-        ret = swr_init(ebur128->swr_ctx);
-        if (ret < 0)
-            return ret;
+        /* one mono context per channel, each picking its channel out of the
+         * interleaved input, so that the channels can be over-sampled in
+         * parallel */
+        for (i = 0; i < nb_channels; i++) {
+            SwrContext *swr = ebur128->swr_ctx[i] = swr_alloc();
+            if (!swr)
+                return AVERROR(ENOMEM);
+
+            av_opt_set_int(swr, "in_channel_count",      nb_channels, 0);
+            av_opt_set_int(swr, "used_channel_count",    1, 0);
+            av_opt_set_int(swr, "in_channel_layout",     AV_CH_LAYOUT_MONO, 0);
+            av_opt_set_int(swr, "in_sample_rate",        outlink->sample_rate, 0);
+            av_opt_set_sample_fmt(swr, "in_sample_fmt",  outlink->format, 0);
+
+            av_opt_set_int(swr, "out_channel_layout",    AV_CH_LAYOUT_MONO, 0);
+            av_opt_set_int(swr, "out_sample_rate",       192000, 0);
+            av_opt_set_sample_fmt(swr, "out_sample_fmt", outlink->format, 0);
+
+            ebur128->swr_channel[i] = i;
+            ret = swr_set_channel_mapping(swr, &ebur128->swr_channel[i]);
+            if (ret < 0)
+                return ret;
+
+            ret = swr_init(swr);
+            if (ret < 0)
+                return ret;
+        }
     }
 #endif
 
@@ -539,99 +556,171 @@ static int gate_update(struct integrator *integ, double power,
     return gate_hist_pos;
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
+#if CONFIG_SWRESAMPLE
+static int true_peak_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    int i, ch, idx_insample;
-    AVFilterContext *ctx = inlink->dst;
     EBUR128Context *ebur128 = ctx->priv;
-    const int nb_channels = ebur128->nb_channels;
-    const int nb_samples  = insamples->nb_samples;
-    const double *samples = (double *)insamples->data[0];
-    AVFrame *pic = ebur128->outpicref;
-
-#if CONFIG_SWRESAMPLE
-    if (ebur128->peak_mode & PEAK_MODE_TRUE_PEAKS) {
-        const double *swr_samples = ebur128->swr_buf;
-        int ret = swr_convert(ebur128->swr_ctx, (uint8_t**)&ebur128->swr_buf, 19200,
-                              (const uint8_t **)insamples->data, nb_samples);
+    AVFrame *insamples = arg;
+    const int start = (ebur128->nb_channels *  jobnr   ) / nb_jobs;
+    const int end   = (ebur128->nb_channels * (jobnr+1)) / nb_jobs;
+    int ch, i;
+
+    for (ch = start; ch < end; ch++) {
+        double *swr_samples = ebur128->swr_buf + ch * 19200;
+        double peak = 0.0;
+        int ret = swr_convert(ebur128->swr_ctx[ch], (uint8_t**)&swr_samples, 19200,
+                              (const uint8_t **)insamples->data, insamples->nb_samples);
         if (ret < 0)
             return ret;
-        for (ch = 0; ch < nb_channels; ch++)
-            ebur128->true_peaks_per_frame[ch] = 0.0;
-        for (idx_insample = 0; idx_insample < ret; idx_insample++) {
-            for (ch = 0; ch < nb_channels; ch++) {
-                ebur128->true_peaks[ch] = FFMAX(ebur128->true_peaks[ch], fabs(*swr_samples));
-                ebur128->true_peaks_per_frame[ch] = FFMAX(ebur128->true_peaks_per_frame[ch],
-                                                          fabs(*swr_samples));
-                swr_samples++;
-            }
-        }
+        for (i = 0; i < ret; i++)
+            peak = FFMAX(peak, fabs(swr_samples[i]));
+        ebur128->true_peaks_per_frame[ch] = peak;
+        ebur128->true_peaks[ch] = FFMAX(ebur128->true_peaks[ch], peak);
     }
-#endif
 
-    for (idx_insample = 0; idx_insample < nb_samples; idx_insample++) {
-        const int bin_id_400  = ebur128->i400.cache_pos;
-        const int bin_id_3000 = ebur128->i3000.cache_pos;
+    return 0;
+}
+#endif
 
-#define MOVE_TO_NEXT_CACHED_ENTRY(time) do {                \
-    ebur128->i##time.cache_pos++;                           \
-    if (ebur128->i##time.cache_pos == I##time##_BINS) {     \
-        ebur128->i##time.filled    = 1;                     \
-        ebur128->i##time.cache_pos = 0;                     \
-    }                                                       \
-} while (0)
+typedef struct ThreadData {
+    const double *samples;          ///< first interleaved sample of the run
+    int nb_samples;                 ///< number of samples in the run
+} ThreadData;
 
-        MOVE_TO_NEXT_CACHED_ENTRY(400);
-        MOVE_TO_NEXT_CACHED_ENTRY(3000);
+/**
+ * Run the K-weighting filters over a run of samples for a range of
+ * channels, and update the 400ms and 3s integrators with the results.
+ * The run must not cross a 100ms gating block boundary.
+ */
+static int filter_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    EBUR128Context *ebur128 = ctx->priv;
+    ThreadData *td = arg;
+    const int nb_channels = ebur128->nb_channels;
+    const int nb_samples  = td->nb_samples;
+    const int start = (nb_channels *  jobnr   ) / nb_jobs;
+    const int end   = (nb_channels * (jobnr+1)) / nb_jobs;
+    int ch, i;
+
+    for (ch = start; ch < end; ch++) {
+        const double *samples = td->samples + ch;
+        double *cache_400  = ebur128->i400.cache[ch];
+        double *cache_3000 = ebur128->i3000.cache[ch];
+        int bin_id_400  = ebur128->i400.cache_pos;
+        int bin_id_3000 = ebur128->i3000.cache_pos;
+        double sum_400, sum_3000;
+        double x0, x1, x2, y0, y1, y2, z0, z1, z2;
+
+        if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS) {
+            double peak = ebur128->sample_peaks[ch];
+            for (i = 0; i < nb_samples; i++)
+                peak = FFMAX(peak, fabs(samples[i * nb_channels]));
+            ebur128->sample_peaks[ch] = peak;
+        }
 
-        for (ch = 0; ch < nb_channels; ch++) {
-            double bin;
+        if (!ebur128->ch_weighting[ch]) {
+            ebur128->x[ch * 3] = samples[(nb_samples - 1) * nb_channels];
+            continue;
+        }
 
-            if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS)
-                ebur128->sample_peaks[ch] = FFMAX(ebur128->sample_peaks[ch], fabs(*samples));
+        /* keep the filter states in registers for the whole run */
+        x0 = ebur128->x[ch * 3]; x1 = ebur128->x[ch * 3 + 1]; x2 = ebur128->x[ch * 3 + 2];
+        y0 = ebur128->y[ch * 3]; y1 = ebur128->y[ch * 3 + 1]; y2 = ebur128->y[ch * 3 + 2];
+        z0 = ebur128->z[ch * 3]; z1 = ebur128->z[ch * 3 + 1]; z2 = ebur128->z[ch * 3 + 2];
+        sum_400  = ebur128->i400.sum [ch];
+        sum_3000 = ebur128->i3000.sum[ch];
 
-            ebur128->x[ch * 3] = *samples++; // set X[i]
+        for (i = 0; i < nb_samples; i++) {
+            double bin;
 
-            if (!ebur128->ch_weighting[ch])
-                continue;
+            x0 = samples[i * nb_channels];
 
             /* Y[i] = X[i]*b0 + X[i-1]*b1 + X[i-2]*b2 - Y[i-1]*a1 - Y[i-2]*a2 */
-#define FILTER(Y, X, name) do {                                                 \
-            double *dst = ebur128->Y + ch*3;                                    \
-            double *src = ebur128->X + ch*3;                                    \
-            dst[2] = dst[1];                                                    \
-            dst[1] = dst[0];                                                    \
-            dst[0] = src[0]*name##_B0 + src[1]*name##_B1 + src[2]*name##_B2     \
-                                      - dst[1]*name##_A1 - dst[2]*name##_A2;    \
-} while (0)
+            y2 = y1; y1 = y0;
+            y0 = x0*PRE_B0 + x1*PRE_B1 + x2*PRE_B2 - y1*PRE_A1 - y2*PRE_A2; // apply pre-filter
+            x2 = x1; x1 = x0;
+            z2 = z1; z1 = z0;
+            z0 = y0*RLB_B0 + y1*RLB_B1 + y2*RLB_B2 - z1*RLB_A1 - z2*RLB_A2; // apply RLB-filter
 
-            // TODO: merge both filters in one?
-            FILTER(y, x, PRE);  // apply pre-filter
-            ebur128->x[ch * 3 + 2] = ebur128->x[ch * 3 + 1];
-            ebur128->x[ch * 3 + 1] = ebur128->x[ch * 3    ];
-            FILTER(z, y, RLB);  // apply RLB-filter
-
-            bin = ebur128->z[ch * 3] * ebur128->z[ch * 3];
+            bin = z0 * z0;
 
             /* add the new value, and limit the sum to the cache size (400ms or 3s)
              * by removing the oldest one */
-            ebur128->i400.sum [ch] = ebur128->i400.sum [ch] + bin - ebur128->i400.cache [ch][bin_id_400];
-            ebur128->i3000.sum[ch] = ebur128->i3000.sum[ch] + bin - ebur128->i3000.cache[ch][bin_id_3000];
+            sum_400  = sum_400  + bin - cache_400 [bin_id_400 ];
+            sum_3000 = sum_3000 + bin - cache_3000[bin_id_3000];
 
             /* override old cache entry with the new value */
-            ebur128->i400.cache [ch][bin_id_400 ] = bin;
-            ebur128->i3000.cache[ch][bin_id_3000] = bin;
+            cache_400 [bin_id_400 ] = bin;
+            cache_3000[bin_id_3000] = bin;
+
+            if (++bin_id_400  == I400_BINS)  bin_id_400  = 0;
+            if (++bin_id_3000 == I3000_BINS) bin_id_3000 = 0;
         }
 
+        ebur128->x[ch * 3] = x0; ebur128->x[ch * 3 + 1] = x1; ebur128->x[ch * 3 + 2] = x2;
+        ebur128->y[ch * 3] = y0; ebur128->y[ch * 3 + 1] = y1; ebur128->y[ch * 3 + 2] = y2;
+        ebur128->z[ch * 3] = z0; ebur128->z[ch * 3 + 1] = z1; ebur128->z[ch * 3 + 2] = z2;
+        ebur128->i400.sum [ch] = sum_400;
+        ebur128->i3000.sum[ch] = sum_3000;
+    }
+
+    return 0;
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
+{
+    int i, ch, idx_insample, nb_run;
+    AVFilterContext *ctx = inlink->dst;
+    EBUR128Context *ebur128 = ctx->priv;
+    const int nb_channels = ebur128->nb_channels;
+    const int nb_samples  = insamples->nb_samples;
+    const double *samples = (double *)insamples->data[0];
+    const int nb_jobs = FFMIN(nb_channels, ff_filter_get_nb_threads(ctx));
+    AVFrame *pic = ebur128->outpicref;
+
+#if CONFIG_SWRESAMPLE
+    if (ebur128->peak_mode & PEAK_MODE_TRUE_PEAKS) {
+        int ret[MAX_CHANNELS];
+
+        ctx->internal->execute(ctx, true_peak_channels, insamples, ret, nb_jobs);
+        for (i = 0; i < nb_jobs; i++)
+            if (ret[i] < 0)
+                return ret[i];
+    }
+#endif
+
+    /* The channels are independent between two gating points, so the
+     * samples are processed in runs ending at the next gating point, with
+     * the channels of each run spread over the threads. */
+    for (idx_insample = 0; idx_insample < nb_samples; idx_insample += nb_run) {
+        ThreadData td;
+
+        nb_run = FFMIN(nb_samples - idx_insample, 4800 - ebur128->sample_count);
+        td.samples    = samples + idx_insample * nb_channels;
+        td.nb_samples = nb_run;
+        ctx->internal->execute(ctx, filter_channels, &td, NULL, nb_jobs);
+
+#define MOVE_CACHED_ENTRY(time, n) do {                     \
+    ebur128->i##time.cache_pos += n;                        \
+    if (ebur128->i##time.cache_pos >= I##time##_BINS) {     \
+        ebur128->i##time.filled     = 1;                    \
+        ebur128->i##time.cache_pos -= I##time##_BINS;       \
+    }                                                       \
+} while (0)
+
+        MOVE_CACHED_ENTRY(400,  nb_run);
+        MOVE_CACHED_ENTRY(3000, nb_run);
+
         /* For integrated loudness, gating blocks are 400ms long with 75%
          * overlap (see BS.1770-2 p5), so a re-computation is needed each 100ms
          * (4800 samples at 48kHz). */
-        if (++ebur128->sample_count == 4800) {
+        ebur128->sample_count += nb_run;
+        if (ebur128->sample_count == 4800) {
             double loudness_400, loudness_3000;
             double power_400 = 1e-12, power_3000 = 1e-12;
             AVFilterLink *outlink = ctx->outputs[0];
             const int64_t pts = insamples->pts +
-                av_rescale_q(idx_insample, (AVRational){ 1, inlink->sample_rate },
+                av_rescale_q(idx_insample + nb_run - 1, (AVRational){ 1, inlink->sample_rate },
                              outlink->time_base);
 
             ebur128->sample_count = 0;
@@ -923,7 +1012,10 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_frame_free(&ebur128->outpicref);
 #if CONFIG_SWRESAMPLE
     av_freep(&ebur128->swr_buf);
-    swr_free(&ebur128->swr_ctx);
+    if (ebur128->swr_ctx)
+        for (i = 0; i < ebur128->nb_channels; i++)
+            swr_free(&ebur128->swr_ctx[i]);
+    av_freep(&ebur128->swr_ctx);
 #endif
 }
 
@@ -947,5 +1039,5 @@ AVFilter ff_af_ebur128 = {
     .inputs        = ebur128_inputs,
     .outputs       = NULL,
     .priv_class    = &ebur128_class,
-    .flags         = AVFILTER_FLAG_DYNAMIC_OUTPUTS,
+    .flags         = AVFILTER_FLAG_DYNAMIC_OUTPUTS | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -27,6 +27,18 @@ static inline FFFrameBucket *bucket(FFFrameQueue *fq, size_t idx)
     return &fq->queue[(fq->tail + idx) & (fq->allocated - 1)];
 }
 
+static size_t frame_bytes(const AVFrame *frame)
+{
+    size_t bytes = 0;
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(frame->buf) && frame->buf[i]; i++)
+        bytes += frame->buf[i]->size;
+    for (i = 0; i < frame->nb_extended_buf; i++)
+        bytes += frame->extended_buf[i]->size;
+    return bytes;
+}
+
 void ff_framequeue_global_init(FFFrameQueueGlobal *fqg)
 {
 }
@@ -88,7 +100,9 @@ int ff_framequeue_add(FFFrameQueue *fq, AVFrame *frame)
     }
     b = bucket(fq, fq->queued);
     b->frame = frame;
+    b->bytes = frame_bytes(frame);
     fq->queued++;
+    fq->queued_bytes += b->bytes;
     fq->total_frames_head++;
     fq->total_samples_head += frame->nb_samples;
     check_consistency(fq);
@@ -103,6 +117,7 @@ AVFrame *ff_framequeue_take(FFFrameQueue *fq)
     av_assert1(fq->queued);
     b = bucket(fq, 0);
     fq->queued--;
+    fq->queued_bytes -= b->bytes;
     fq->tail++;
     fq->tail &= fq->allocated - 1;
     fq->total_frames_tail++;
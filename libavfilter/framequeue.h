@@ -33,6 +33,7 @@
 
 typedef struct FFFrameBucket {
     AVFrame *frame;
+    size_t bytes;
 } FFFrameBucket;
 
 /**
@@ -73,6 +74,11 @@ typedef struct FFFrameQueue {
      */
     size_t queued;
 
+    /**
+     * Total size of the buffers referenced by the queued frames.
+     */
+    size_t queued_bytes;
+
     /**
      * Pre-allocated bucket for queues of size 1.
      */
@@ -148,6 +154,14 @@ static inline size_t ff_framequeue_queued_frames(const FFFrameQueue *fq)
     return fq->queued;
 }
 
+/**
+ * Get the total size of the buffers referenced by the queued frames.
+ */
+static inline size_t ff_framequeue_queued_bytes(const FFFrameQueue *fq)
+{
+    return fq->queued_bytes;
+}
+
 /**
  * Get the number of queued samples.
  */
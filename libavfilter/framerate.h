@@ -50,6 +50,7 @@ typedef struct FrameRateContext {
 
     av_pixelutils_sad_fn sad;           ///< Sum of the absolute difference function (scene detect only)
     double prev_mafd;                   ///< previous MAFD                           (scene detect only)
+    int64_t *slice_sad;                 ///< per-job SAD sums                        (scene detect only)
 
     int blend_factor_max;
     int bitdepth;
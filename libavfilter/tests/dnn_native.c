@@ -0,0 +1,216 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/lfg.h"
+#include "libavutil/time.h"
+#include "libavfilter/dnn_backend_native.c"
+
+typedef struct RefLayer {
+    const float *kernel, *biases;
+    ActivationFunc activation;
+    int input_num, output_num, kernel_size;
+} RefLayer;
+
+static const RefLayer srcnn_layers[] = {
+    { srcnn_conv1_kernel, srcnn_conv1_bias, RELU,     1, 64, 9 },
+    { srcnn_conv2_kernel, srcnn_conv2_bias, RELU,    64, 32, 1 },
+    { srcnn_conv3_kernel, srcnn_conv3_bias, RELU,    32,  1, 5 },
+};
+
+static const RefLayer espcn_layers[] = {
+    { espcn_conv1_kernel, espcn_conv1_bias, TANH,     1, 64, 5 },
+    { espcn_conv2_kernel, espcn_conv2_bias, TANH,    64, 32, 3 },
+    { espcn_conv3_kernel, espcn_conv3_bias, SIGMOID, 32,  4, 3 },
+};
+
+/* straightforward implementation of the layers, as a reference */
+static void ref_convolve(const float *input, float *output, const RefLayer *l,
+                         int width, int height)
+{
+    int y, x, n_filter, ch, kernel_y, kernel_x;
+    int radius = l->kernel_size >> 1;
+    int src_linesize = width * l->input_num;
+    int filter_linesize = l->kernel_size * l->input_num;
+    int filter_size = l->kernel_size * filter_linesize;
+
+    for (y = 0; y < height; ++y){
+        for (x = 0; x < width; ++x){
+            for (n_filter = 0; n_filter < l->output_num; ++n_filter){
+                output[n_filter] = l->biases[n_filter];
+                for (ch = 0; ch < l->input_num; ++ch){
+                    for (kernel_y = 0; kernel_y < l->kernel_size; ++kernel_y){
+                        for (kernel_x = 0; kernel_x < l->kernel_size; ++kernel_x){
+                            output[n_filter] += input[CLAMP_TO_EDGE(y + kernel_y - radius, height) * src_linesize +
+                                                      CLAMP_TO_EDGE(x + kernel_x - radius, width) * l->input_num + ch] *
+                                                l->kernel[n_filter * filter_size + kernel_y * filter_linesize +
+                                                          kernel_x * l->input_num + ch];
+                        }
+                    }
+                }
+                switch (l->activation){
+                case RELU:
+                    output[n_filter] = FFMAX(output[n_filter], 0.0);
+                    break;
+                case TANH:
+                    output[n_filter] = 2.0f  / (1.0f + exp(-2.0f * output[n_filter])) - 1.0f;
+                    break;
+                case SIGMOID:
+                    output[n_filter] = 1.0f / (1.0f + exp(-output[n_filter]));
+                }
+            }
+            output += l->output_num;
+        }
+    }
+}
+
+static void ref_depth_to_space(const float *input, float *output, int block_size,
+                               int width, int height, int channels)
+{
+    int y, x, by, bx, ch;
+    int new_channels = channels / (block_size * block_size);
+    int output_linesize = width * channels;
+    int by_linesize = output_linesize / block_size;
+    int x_linesize = new_channels * block_size;
+
+    for (y = 0; y < height; ++y){
+        for (x = 0; x < width; ++x){
+            for (by = 0; by < block_size; ++by){
+                for (bx = 0; bx < block_size; ++bx){
+                    for (ch = 0; ch < new_channels; ++ch){
+                        output[by * by_linesize + x * x_linesize + bx * new_channels + ch] = input[ch];
+                    }
+                    input += new_channels;
+                }
+            }
+        }
+        output += output_linesize;
+    }
+}
+
+/* run the slices serially, last one first, in place of the slice threads
+ * of a filtergraph */
+static int execute_reverse(AVFilterContext *ctx, avfilter_action_func *func,
+                           void *arg, int *ret, int nb_jobs)
+{
+    int i;
+
+    for (i = nb_jobs - 1; i >= 0; i--) {
+        int r = func(ctx, arg, i, nb_jobs);
+        if (ret)
+            ret[i] = r;
+    }
+    return 0;
+}
+
+static int test_model(const char *name, DNNDefaultModel type,
+                      const RefLayer *layers, int nb_layers, int block_size,
+                      int width, int height, int runs, int slices)
+{
+    AVFilterInternal internal = { execute_reverse };
+    AVFilterGraph graph = { .nb_threads = slices };
+    AVFilterContext ctx = { .graph = &graph, .internal = &internal };
+    DNNModel *model = ff_dnn_load_default_model_native(type);
+    DNNData input = { NULL, width, height, 1 }, output;
+    float *ref[2] = { NULL };
+    int i, ret = 1, channels = 1;
+    int64_t t;
+    AVLFG lfg;
+
+    if (!model || model->set_input_output(model->model, &input, &output) != DNN_SUCCESS) {
+        fprintf(stderr, "%s: could not set up model\n", name);
+        goto end;
+    }
+    if (slices > 1)
+        model->filter_ctx = &ctx;
+
+    ref[0] = av_malloc_array(width * height, 64 * sizeof(float));
+    ref[1] = av_malloc_array(width * height, 64 * sizeof(float));
+    if (!ref[0] || !ref[1])
+        goto end;
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+    for (i = 0; i < width * height; i++)
+        input.data[i] = ref[0][i] = av_lfg_get(&lfg) / (float)UINT_MAX;
+
+    for (i = 0; i < nb_layers; i++) {
+        ref_convolve(ref[i & 1], ref[!(i & 1)], &layers[i], width, height);
+        channels = layers[i].output_num;
+    }
+    if (block_size) {
+        ref_depth_to_space(ref[nb_layers & 1], ref[!(nb_layers & 1)],
+                           block_size, width, height, channels);
+        nb_layers++;
+    }
+
+    t = av_gettime_relative();
+    for (i = 0; i < runs; i++) {
+        if (ff_dnn_execute_model_native(model) != DNN_SUCCESS) {
+            fprintf(stderr, "%s: could not execute model\n", name);
+            goto end;
+        }
+    }
+    t = av_gettime_relative() - t;
+
+    /* the reference accumulates in the same order, so the results must be
+     * identical whatever the slicing */
+    for (i = 0; i < output.width * output.height * output.channels; i++) {
+        float a = ref[nb_layers & 1][i], b = output.data[i];
+        if (memcmp(&a, &b, sizeof(a))) {
+            fprintf(stderr, "%s: mismatch at %d with %d slices: %.9g != %.9g\n",
+                    name, i, slices, b, a);
+            goto end;
+        }
+    }
+
+    printf("%s, %d slices: ok\n", name, slices);
+    if (runs > 1)
+        fprintf(stderr, "%s: %dx%d, %d slices, %"PRId64" us per run\n",
+                name, width, height, slices, t / runs);
+    ret = 0;
+end:
+    av_freep(&ref[0]);
+    av_freep(&ref[1]);
+    ff_dnn_free_model_native(&model);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int width  = argc > 2 ? atoi(argv[1]) : 48;
+    int height = argc > 2 ? atoi(argv[2]) : 32;
+    int runs   = argc > 3 ? atoi(argv[3]) : 1;
+    int ret = 0, slices;
+
+    if (width <= 0 || height <= 0 || runs <= 0) {
+        fprintf(stderr, "usage: %s [width height [runs]]\n", argv[0]);
+        return 1;
+    }
+
+    for (slices = 1; slices <= 7; slices += 6) {
+        ret |= test_model("srcnn", DNN_SRCNN, srcnn_layers, FF_ARRAY_ELEMS(srcnn_layers), 0,
+                          width, height, runs, slices);
+        ret |= test_model("espcn", DNN_ESPCN, espcn_layers, FF_ARRAY_ELEMS(espcn_layers), 2,
+                          width, height, runs, slices);
+    }
+
+    return ret;
+}
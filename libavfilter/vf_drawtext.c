@@ -148,7 +148,13 @@ typedef struct DrawTextContext {
     AVBPrint expanded_fontcolor;    ///< used to contain the expanded fontcolor spec
     int ft_load_flags;              ///< flags used for loading fonts, see FT_LOAD_*
     FT_Vector *positions;           ///< positions for each element in the text
-    size_t nb_positions;            ///< number of elements of positions array
+    struct Glyph **run;             ///< glyph drawn for each element in the text, NULL if none
+    size_t nb_positions;            ///< number of elements of positions and run arrays
+    int run_len;                    ///< number of elements of the current text
+    char *layout_text;              ///< expanded text the current layout was computed for
+    unsigned int layout_fontsize;   ///< font size the current layout was computed for
+    int text_w, text_h;             ///< size of the current layout
+    int ascent, descent;            ///< max glyph ascent and descent of the current layout
     char *textfile;                 ///< file with text to be drawn
     int x;                          ///< x position to start drawing text
     int y;                          ///< y position to start drawing text
@@ -805,6 +811,8 @@ static av_cold void uninit(AVFilterContext *ctx)
     s->x_pexpr = s->y_pexpr = s->a_pexpr = s->fontsize_pexpr = NULL;
 
     av_freep(&s->positions);
+    av_freep(&s->run);
+    av_freep(&s->layout_text);
     s->nb_positions = 0;
 
     av_tree_enumerate(s->glyphs, NULL, NULL, glyph_enu_free);
@@ -1174,51 +1182,82 @@ static int expand_text(AVFilterContext *ctx, char *text, AVBPrint *bp)
     return 0;
 }
 
-static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
-                       int width, int height,
-                       FFDrawColor *color,
-                       int x, int y, int borderw)
+static void draw_glyphs(DrawTextContext *s, uint8_t *data[], int linesize[],
+                        int width, int height,
+                        FFDrawColor *color,
+                        int x, int y, int borderw)
 {
-    char *text = s->expanded_text.str;
-    uint32_t code = 0;
     int i, x1, y1;
-    uint8_t *p;
-    Glyph *glyph = NULL;
 
-    for (i = 0, p = text; *p; i++) {
-        FT_Bitmap bitmap;
-        Glyph dummy = { 0 };
-        GET_UTF8(code, *p++, continue;);
+    for (i = 0; i < s->run_len; i++) {
+        const Glyph *glyph = s->run[i];
+        const FT_Bitmap *bitmap;
 
-        /* skip new line chars, just go to new line */
-        if (code == '\n' || code == '\r' || code == '\t')
+        if (!glyph)
             continue;
 
-        dummy.code = code;
-        dummy.fontsize = s->fontsize;
-        glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
-
-        bitmap = borderw ? glyph->border_bitmap : glyph->bitmap;
-
-        if (glyph->bitmap.pixel_mode != FT_PIXEL_MODE_MONO &&
-            glyph->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
-            return AVERROR(EINVAL);
+        bitmap = borderw ? &glyph->border_bitmap : &glyph->bitmap;
 
         x1 = s->positions[i].x+s->x+x - borderw;
         y1 = s->positions[i].y+s->y+y - borderw;
 
         ff_blend_mask(&s->dc, color,
-                      frame->data, frame->linesize, width, height,
-                      bitmap.buffer, bitmap.pitch,
-                      bitmap.width, bitmap.rows,
-                      bitmap.pixel_mode == FT_PIXEL_MODE_MONO ? 0 : 3,
+                      data, linesize, width, height,
+                      bitmap->buffer, bitmap->pitch,
+                      bitmap->width, bitmap->rows,
+                      bitmap->pixel_mode == FT_PIXEL_MODE_MONO ? 0 : 3,
                       0, x1, y1);
     }
+}
+
+typedef struct ThreadData {
+    AVFrame *frame;
+    int width;
+    int top, bottom;
+    FFDrawColor fontcolor;
+    FFDrawColor shadowcolor;
+    FFDrawColor bordercolor;
+    FFDrawColor boxcolor;
+} ThreadData;
+
+/* Draw everything falling into one band of rows of the text area. The bands
+ * are aligned on the chroma subsampling, so the result does not depend on
+ * the number of jobs. */
+static int draw_text_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DrawTextContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *frame = td->frame;
+    const int area_h = td->bottom - td->top;
+    const int slice_start = ff_draw_round_to_sub(&s->dc, 1, -1, td->top + (area_h *  jobnr)      / nb_jobs);
+    const int slice_end   = jobnr == nb_jobs - 1 ? td->bottom :
+                            ff_draw_round_to_sub(&s->dc, 1, -1, td->top + (area_h * (jobnr + 1)) / nb_jobs);
+    uint8_t *data[4] = { NULL };
+    int i;
+
+    for (i = 0; i < s->dc.nb_planes; i++)
+        data[i] = frame->data[i] + (slice_start >> s->dc.vsub[i]) * frame->linesize[i];
+
+    if (s->draw_box)
+        ff_blend_rectangle(&s->dc, &td->boxcolor,
+                           data, frame->linesize, td->width, slice_end - slice_start,
+                           s->x - s->boxborderw, s->y - s->boxborderw - slice_start,
+                           s->text_w + s->boxborderw * 2, s->text_h + s->boxborderw * 2);
+
+    if (s->shadowx || s->shadowy)
+        draw_glyphs(s, data, frame->linesize, td->width, slice_end - slice_start,
+                    &td->shadowcolor, s->shadowx, s->shadowy - slice_start, 0);
+
+    if (s->borderw)
+        draw_glyphs(s, data, frame->linesize, td->width, slice_end - slice_start,
+                    &td->bordercolor, 0, -slice_start, s->borderw);
+
+    draw_glyphs(s, data, frame->linesize, td->width, slice_end - slice_start,
+                &td->fontcolor, 0, -slice_start, 0);
 
     return 0;
 }
 
-
 static void update_color_with_alpha(DrawTextContext *s, FFDrawColor *color, const FFDrawColor incolor)
 {
     *color = incolor;
@@ -1241,17 +1280,18 @@ static void update_alpha(DrawTextContext *s)
         s->alpha = 256 * alpha;
 }
 
-static int draw_text(AVFilterContext *ctx, AVFrame *frame,
-                     int width, int height)
+/**
+ * Load the glyphs of the expanded text and compute their positions.
+ * The result only depends on the text and the font size, so it is kept
+ * until either of them changes.
+ */
+static int update_layout(AVFilterContext *ctx)
 {
     DrawTextContext *s = ctx->priv;
-    AVFilterLink *inlink = ctx->inputs[0];
-
+    char *text = s->expanded_text.str;
     uint32_t code = 0, prev_code = 0;
     int x = 0, y = 0, i = 0, ret;
     int max_text_line_w = 0, len;
-    int box_w, box_h;
-    char *text;
     uint8_t *p;
     int y_min = 32000, y_max = -32000;
     int x_min = 32000, x_max = -32000;
@@ -1259,71 +1299,17 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     Glyph *glyph = NULL, *prev_glyph = NULL;
     Glyph dummy = { 0 };
 
-    time_t now = time(0);
-    struct tm ltime;
-    AVBPrint *bp = &s->expanded_text;
+    av_freep(&s->layout_text);
 
-    FFDrawColor fontcolor;
-    FFDrawColor shadowcolor;
-    FFDrawColor bordercolor;
-    FFDrawColor boxcolor;
-
-    av_bprint_clear(bp);
-
-    if(s->basetime != AV_NOPTS_VALUE)
-        now= frame->pts*av_q2d(ctx->inputs[0]->time_base) + s->basetime/1000000;
-
-    switch (s->exp_mode) {
-    case EXP_NONE:
-        av_bprintf(bp, "%s", s->text);
-        break;
-    case EXP_NORMAL:
-        if ((ret = expand_text(ctx, s->text, &s->expanded_text)) < 0)
-            return ret;
-        break;
-    case EXP_STRFTIME:
-        localtime_r(&now, &ltime);
-        av_bprint_strftime(bp, s->text, &ltime);
-        break;
-    }
-
-    if (s->tc_opt_string) {
-        char tcbuf[AV_TIMECODE_STR_SIZE];
-        av_timecode_make_string(&s->tc, tcbuf, inlink->frame_count_out);
-        av_bprint_clear(bp);
-        av_bprintf(bp, "%s%s", s->text, tcbuf);
-    }
-
-    if (!av_bprint_is_complete(bp))
-        return AVERROR(ENOMEM);
-    text = s->expanded_text.str;
     if ((len = s->expanded_text.len) > s->nb_positions) {
-        if (!(s->positions =
-              av_realloc(s->positions, len*sizeof(*s->positions))))
-            return AVERROR(ENOMEM);
-        s->nb_positions = len;
-    }
-
-    if (s->fontcolor_expr[0]) {
-        /* If expression is set, evaluate and replace the static value */
-        av_bprint_clear(&s->expanded_fontcolor);
-        if ((ret = expand_text(ctx, s->fontcolor_expr, &s->expanded_fontcolor)) < 0)
-            return ret;
-        if (!av_bprint_is_complete(&s->expanded_fontcolor))
-            return AVERROR(ENOMEM);
-        av_log(s, AV_LOG_DEBUG, "Evaluated fontcolor is '%s'\n", s->expanded_fontcolor.str);
-        ret = av_parse_color(s->fontcolor.rgba, s->expanded_fontcolor.str, -1, s);
-        if (ret)
+        if ((ret = av_reallocp_array(&s->positions, len, sizeof(*s->positions))) < 0 ||
+            (ret = av_reallocp_array(&s->run, len, sizeof(*s->run))) < 0) {
+            s->nb_positions = 0;
             return ret;
-        ff_draw_color(&s->dc, &s->fontcolor, s->fontcolor.rgba);
+        }
+        s->nb_positions = len;
     }
 
-    x = 0;
-    y = 0;
-
-    if ((ret = update_fontsize(ctx)) < 0)
-        return ret;
-
     /* load and cache glyphs */
     for (i = 0, p = text; *p; i++) {
         GET_UTF8(code, *p++, continue;);
@@ -1349,6 +1335,7 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     /* compute and save position for each glyph */
     glyph = NULL;
     for (i = 0, p = text; *p; i++) {
+        s->run[i] = NULL;
         GET_UTF8(code, *p++, continue;);
 
         /* skip the \n in the sequence \r\n */
@@ -1382,17 +1369,105 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
         s->positions[i].y = y - glyph->bitmap_top + y_max;
         if (code == '\t') x  = (x / s->tabsize + 1)*s->tabsize;
         else              x += glyph->advance;
+
+        if (code == '\t')
+            continue;
+        if (glyph->bitmap.pixel_mode != FT_PIXEL_MODE_MONO &&
+            glyph->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
+            return AVERROR(EINVAL);
+        s->run[i] = glyph;
     }
+    s->run_len = i;
 
     max_text_line_w = FFMAX(x, max_text_line_w);
 
-    s->var_values[VAR_TW] = s->var_values[VAR_TEXT_W] = max_text_line_w;
-    s->var_values[VAR_TH] = s->var_values[VAR_TEXT_H] = y + s->max_glyph_h;
+    s->text_w  = max_text_line_w;
+    s->text_h  = y + s->max_glyph_h;
+    s->ascent  = y_max;
+    s->descent = y_min;
+
+    s->layout_fontsize = s->fontsize;
+    s->layout_text = av_strdup(text);
+    if (!s->layout_text)
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
+static int draw_text(AVFilterContext *ctx, AVFrame *frame,
+                     int width, int height)
+{
+    DrawTextContext *s = ctx->priv;
+    AVFilterLink *inlink = ctx->inputs[0];
+
+    int i, ret, nb_jobs;
+    int box_w, box_h;
+    int top, bottom;
+
+    time_t now = time(0);
+    struct tm ltime;
+    AVBPrint *bp = &s->expanded_text;
+    ThreadData td;
+
+    av_bprint_clear(bp);
+
+    if(s->basetime != AV_NOPTS_VALUE)
+        now= frame->pts*av_q2d(ctx->inputs[0]->time_base) + s->basetime/1000000;
+
+    switch (s->exp_mode) {
+    case EXP_NONE:
+        av_bprintf(bp, "%s", s->text);
+        break;
+    case EXP_NORMAL:
+        if ((ret = expand_text(ctx, s->text, &s->expanded_text)) < 0)
+            return ret;
+        break;
+    case EXP_STRFTIME:
+        localtime_r(&now, &ltime);
+        av_bprint_strftime(bp, s->text, &ltime);
+        break;
+    }
+
+    if (s->tc_opt_string) {
+        char tcbuf[AV_TIMECODE_STR_SIZE];
+        av_timecode_make_string(&s->tc, tcbuf, inlink->frame_count_out);
+        av_bprint_clear(bp);
+        av_bprintf(bp, "%s%s", s->text, tcbuf);
+    }
+
+    if (!av_bprint_is_complete(bp))
+        return AVERROR(ENOMEM);
+
+    if (s->fontcolor_expr[0]) {
+        /* If expression is set, evaluate and replace the static value */
+        av_bprint_clear(&s->expanded_fontcolor);
+        if ((ret = expand_text(ctx, s->fontcolor_expr, &s->expanded_fontcolor)) < 0)
+            return ret;
+        if (!av_bprint_is_complete(&s->expanded_fontcolor))
+            return AVERROR(ENOMEM);
+        av_log(s, AV_LOG_DEBUG, "Evaluated fontcolor is '%s'\n", s->expanded_fontcolor.str);
+        ret = av_parse_color(s->fontcolor.rgba, s->expanded_fontcolor.str, -1, s);
+        if (ret)
+            return ret;
+        ff_draw_color(&s->dc, &s->fontcolor, s->fontcolor.rgba);
+    }
+
+    if ((ret = update_fontsize(ctx)) < 0)
+        return ret;
+
+    if (!s->layout_text || s->layout_fontsize != s->fontsize ||
+        strcmp(s->layout_text, s->expanded_text.str)) {
+        if ((ret = update_layout(ctx)) < 0)
+            return ret;
+    }
+
+    s->var_values[VAR_TW] = s->var_values[VAR_TEXT_W] = s->text_w;
+    s->var_values[VAR_TH] = s->var_values[VAR_TEXT_H] = s->text_h;
 
     s->var_values[VAR_MAX_GLYPH_W] = s->max_glyph_w;
     s->var_values[VAR_MAX_GLYPH_H] = s->max_glyph_h;
-    s->var_values[VAR_MAX_GLYPH_A] = s->var_values[VAR_ASCENT ] = y_max;
-    s->var_values[VAR_MAX_GLYPH_D] = s->var_values[VAR_DESCENT] = y_min;
+    s->var_values[VAR_MAX_GLYPH_A] = s->var_values[VAR_ASCENT ] = s->ascent;
+    s->var_values[VAR_MAX_GLYPH_D] = s->var_values[VAR_DESCENT] = s->descent;
 
     s->var_values[VAR_LINE_H] = s->var_values[VAR_LH] = s->max_glyph_h;
 
@@ -1402,13 +1477,13 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     s->x = s->var_values[VAR_X] = av_expr_eval(s->x_pexpr, s->var_values, &s->prng);
 
     update_alpha(s);
-    update_color_with_alpha(s, &fontcolor  , s->fontcolor  );
-    update_color_with_alpha(s, &shadowcolor, s->shadowcolor);
-    update_color_with_alpha(s, &bordercolor, s->bordercolor);
-    update_color_with_alpha(s, &boxcolor   , s->boxcolor   );
+    update_color_with_alpha(s, &td.fontcolor  , s->fontcolor  );
+    update_color_with_alpha(s, &td.shadowcolor, s->shadowcolor);
+    update_color_with_alpha(s, &td.bordercolor, s->bordercolor);
+    update_color_with_alpha(s, &td.boxcolor   , s->boxcolor   );
 
-    box_w = max_text_line_w;
-    box_h = y + s->max_glyph_h;
+    box_w = s->text_w;
+    box_h = s->text_h;
 
     if (s->fix_bounds) {
 
@@ -1436,27 +1511,43 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
             s->y = FFMAX(height - box_h - offsetbottom, 0);
     }
 
-    /* draw box */
-    if (s->draw_box)
-        ff_blend_rectangle(&s->dc, &boxcolor,
-                           frame->data, frame->linesize, width, height,
-                           s->x - s->boxborderw, s->y - s->boxborderw,
-                           box_w + s->boxborderw * 2, box_h + s->boxborderw * 2);
-
-    if (s->shadowx || s->shadowy) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &shadowcolor, s->shadowx, s->shadowy, 0)) < 0)
-            return ret;
+    /* find the rows touched by the box and the glyphs */
+    top    = INT_MAX;
+    bottom = INT_MIN;
+    if (s->draw_box) {
+        top    = s->y - s->boxborderw;
+        bottom = s->y + box_h + s->boxborderw;
     }
+    for (i = 0; i < s->run_len; i++) {
+        const Glyph *glyph = s->run[i];
+        int y1;
 
-    if (s->borderw) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &bordercolor, 0, 0, s->borderw)) < 0)
-            return ret;
+        if (!glyph)
+            continue;
+        y1 = s->positions[i].y + s->y;
+        if (s->shadowx || s->shadowy) {
+            top    = FFMIN(top,    y1 + s->shadowy);
+            bottom = FFMAX(bottom, y1 + s->shadowy + (int)glyph->bitmap.rows);
+        }
+        if (s->borderw) {
+            top    = FFMIN(top,    y1 - s->borderw);
+            bottom = FFMAX(bottom, y1 - s->borderw + (int)glyph->border_bitmap.rows);
+        }
+        top    = FFMIN(top,    y1);
+        bottom = FFMAX(bottom, y1 + (int)glyph->bitmap.rows);
     }
-    if ((ret = draw_glyphs(s, frame, width, height,
-                           &fontcolor, 0, 0, 0)) < 0)
-        return ret;
+    top    = ff_draw_round_to_sub(&s->dc, 1, -1, FFMAX(top, 0));
+    bottom = FFMIN(bottom, height);
+    if (top >= bottom)
+        return 0;
+
+    td.frame  = frame;
+    td.width  = width;
+    td.top    = top;
+    td.bottom = bottom;
+    nb_jobs = FFMIN(ff_filter_get_nb_threads(ctx),
+                    FFMAX((bottom - top) >> s->dc.vsub_max, 1));
+    ctx->internal->execute(ctx, draw_text_slice, &td, NULL, nb_jobs);
 
     return 0;
 }
@@ -1529,5 +1620,5 @@ AVFilter ff_vf_drawtext = {
     .inputs        = avfilter_vf_drawtext_inputs,
     .outputs       = avfilter_vf_drawtext_outputs,
     .process_command = command,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -62,15 +62,14 @@ static void create_lut(EQParameters *param)
 static void apply_lut(EQParameters *param, uint8_t *dst, int dst_stride,
                       const uint8_t *src, int src_stride, int w, int h)
 {
+    const uint8_t *lut = param->lut;
     int x, y;
 
-    if (!param->lut_clean)
-        create_lut(param);
-
     for (y = 0; y < h; y++) {
-        for (x = 0; x < w; x++) {
-            dst[y * dst_stride + x] = param->lut[src[y * src_stride + x]];
-        }
+        for (x = 0; x < w; x++)
+            dst[x] = lut[src[x]];
+        dst += dst_stride;
+        src += src_stride;
     }
 }
 
@@ -248,14 +247,55 @@ static int query_formats(AVFilterContext *ctx)
 
 #define TS2T(ts, tb) ((ts) == AV_NOPTS_VALUE ? NAN : (double)(ts) * av_q2d(tb))
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+} ThreadData;
+
+static int eq_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    EQContext *eq = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *in  = td->in;
+    AVFrame *out = td->out;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(in->format);
+    int i;
+
+    for (i = 0; i < desc->nb_components; i++) {
+        int w = in->width;
+        int h = in->height;
+        int slice_start, slice_end;
+        uint8_t *dst;
+        const uint8_t *src;
+
+        if (i == 1 || i == 2) {
+            w = AV_CEIL_RSHIFT(w, desc->log2_chroma_w);
+            h = AV_CEIL_RSHIFT(h, desc->log2_chroma_h);
+        }
+
+        slice_start = (h *  jobnr     ) / nb_jobs;
+        slice_end   = (h * (jobnr + 1)) / nb_jobs;
+        dst = out->data[i] + slice_start * out->linesize[i];
+        src = in->data[i]  + slice_start * in->linesize[i];
+
+        if (eq->param[i].adjust)
+            eq->param[i].adjust(&eq->param[i], dst, out->linesize[i],
+                                 src, in->linesize[i], w, slice_end - slice_start);
+        else
+            av_image_copy_plane(dst, out->linesize[i],
+                                src, in->linesize[i], w, slice_end - slice_start);
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
     AVFilterLink *outlink = inlink->dst->outputs[0];
     EQContext *eq = ctx->priv;
     AVFrame *out;
+    ThreadData td;
     int64_t pos = in->pkt_pos;
-    const AVPixFmtDescriptor *desc;
     int i;
 
     out = ff_get_video_buffer(outlink, inlink->w, inlink->h);
@@ -265,7 +305,6 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     }
 
     av_frame_copy_props(out, in);
-    desc = av_pix_fmt_desc_get(inlink->format);
 
     eq->var_values[VAR_N]   = inlink->frame_count_out;
     eq->var_values[VAR_POS] = pos == -1 ? NAN : pos;
@@ -278,22 +317,15 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         set_saturation(eq);
     }
 
-    for (i = 0; i < desc->nb_components; i++) {
-        int w = inlink->w;
-        int h = inlink->h;
-
-        if (i == 1 || i == 2) {
-            w = AV_CEIL_RSHIFT(w, desc->log2_chroma_w);
-            h = AV_CEIL_RSHIFT(h, desc->log2_chroma_h);
-        }
+    /* build the tables before the slices start reading them */
+    for (i = 0; i < 3; i++)
+        if (eq->param[i].adjust == apply_lut && !eq->param[i].lut_clean)
+            create_lut(&eq->param[i]);
 
-        if (eq->param[i].adjust)
-            eq->param[i].adjust(&eq->param[i], out->data[i], out->linesize[i],
-                                 in->data[i], in->linesize[i], w, h);
-        else
-            av_image_copy_plane(out->data[i], out->linesize[i],
-                                in->data[i], in->linesize[i], w, h);
-    }
+    td.in  = in;
+    td.out = out;
+    ctx->internal->execute(ctx, eq_slice, &td, NULL,
+                           FFMIN(inlink->h, ff_filter_get_nb_threads(ctx)));
 
     av_frame_free(&in);
     return ff_filter_frame(outlink, out);
@@ -387,5 +419,5 @@ AVFilter ff_vf_eq = {
     .query_formats   = query_formats,
     .init            = initialize,
     .uninit          = uninit,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags           = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
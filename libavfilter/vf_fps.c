@@ -244,16 +244,37 @@ static int write_frame(AVFilterContext *ctx, FPSContext *s, AVFilterLink *outlin
         *again = 1;
         return 0;
 
-    /* Output a copy of the first buffered frame */
+    /* Output a reference to the first buffered frame */
     } else {
-        frame = av_frame_clone(s->frames[0]);
-        if (!frame)
-            return AVERROR(ENOMEM);
+        int64_t in_pts = s->frames[0]->pts;
+        int repeat     = s->cur_frame_out;
+        int ret;
+
+        /* If the second buffered frame is due next, this is the last time
+         * the first one is output, so pass it on instead of referencing it
+         * and freeing it on the next call. */
+        if (s->frames_count == 2 && s->frames[1]->pts <= s->next_pts + 1) {
+            s->cur_frame_out++;
+            frame = shift_frame(ctx, s);
+        } else {
+            frame = av_frame_clone(s->frames[0]);
+            if (!frame)
+                return AVERROR(ENOMEM);
+            s->cur_frame_out++;
+        }
         frame->pts = s->next_pts++;
 
+        /* Tag duplicates so that later stages can skip redoing their work */
+        if (repeat) {
+            ret = av_dict_set_int(&frame->metadata, "lavfi.fps.repeat", repeat, 0);
+            if (ret < 0) {
+                av_frame_free(&frame);
+                return ret;
+            }
+        }
+
         av_log(ctx, AV_LOG_DEBUG, "Writing frame with pts %"PRId64" to pts %"PRId64"\n",
-               s->frames[0]->pts, frame->pts);
-        s->cur_frame_out++;
+               in_pts, frame->pts);
 
         return ff_filter_frame(outlink, frame);
     }
@@ -107,6 +107,31 @@ static int64_t scene_sad8(FrameRateContext *s, uint8_t *p1, int p1_linesize, uin
     return sad;
 }
 
+typedef struct SceneThreadData {
+    AVFrame *crnt, *next;
+} SceneThreadData;
+
+static int scene_sad_slice(AVFilterContext *ctx, void *arg, int job, int nb_jobs)
+{
+    FrameRateContext *s = ctx->priv;
+    SceneThreadData *td = arg;
+    AVFrame *crnt = td->crnt;
+    AVFrame *next = td->next;
+    const int blocks = crnt->height >> 3;
+    const int start  = (blocks *  job   ) / nb_jobs * 8;
+    const int end    = (blocks * (job+1)) / nb_jobs * 8;
+
+    if (s->bitdepth == 8)
+        s->slice_sad[job] = scene_sad8(s, crnt->data[0] + start * crnt->linesize[0], crnt->linesize[0],
+                                          next->data[0] + start * next->linesize[0], next->linesize[0],
+                                          crnt->width, end - start);
+    else
+        s->slice_sad[job] = scene_sad16(s, (const uint16_t*)(crnt->data[0] + start * crnt->linesize[0]), crnt->linesize[0] / 2,
+                                           (const uint16_t*)(next->data[0] + start * next->linesize[0]), next->linesize[0] / 2,
+                                           crnt->width, end - start);
+    return 0;
+}
+
 static double get_scene_score(AVFilterContext *ctx, AVFrame *crnt, AVFrame *next)
 {
     FrameRateContext *s = ctx->priv;
@@ -116,14 +141,16 @@ static double get_scene_score(AVFilterContext *ctx, AVFrame *crnt, AVFrame *next
 
     if (crnt->height == next->height &&
         crnt->width  == next->width) {
-        int64_t sad;
+        SceneThreadData td = { crnt, next };
+        int nb_jobs = FFMIN(FFMAX(1, crnt->height >> 3), ff_filter_get_nb_threads(ctx));
+        int64_t sad = 0;
         double mafd, diff;
+        int i;
 
         ff_dlog(ctx, "get_scene_score() process\n");
-        if (s->bitdepth == 8)
-            sad = scene_sad8(s, crnt->data[0], crnt->linesize[0], next->data[0], next->linesize[0], crnt->width, crnt->height);
-        else
-            sad = scene_sad16(s, (const uint16_t*)crnt->data[0], crnt->linesize[0] / 2, (const uint16_t*)next->data[0], next->linesize[0] / 2, crnt->width, crnt->height);
+        ctx->internal->execute(ctx, scene_sad_slice, &td, NULL, nb_jobs);
+        for (i = 0; i < nb_jobs; i++)
+            sad += s->slice_sad[i];
 
         mafd = (double)sad * 100.0 / FFMAX(1, (crnt->height & ~7) * (crnt->width & ~7)) / (1 << s->bitdepth);
         diff = fabs(mafd - s->prev_mafd);
@@ -267,6 +294,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     FrameRateContext *s = ctx->priv;
     av_frame_free(&s->f0);
     av_frame_free(&s->f1);
+    av_freep(&s->slice_sad);
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -353,6 +381,11 @@ static int config_input(AVFilterLink *inlink)
     if (!s->sad)
         return AVERROR(EINVAL);
 
+    av_freep(&s->slice_sad);
+    s->slice_sad = av_calloc(ff_filter_get_nb_threads(ctx), sizeof(*s->slice_sad));
+    if (!s->slice_sad)
+        return AVERROR(ENOMEM);
+
     s->srce_time_base = inlink->time_base;
 
     ff_framerate_init(s);
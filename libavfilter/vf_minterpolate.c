@@ -189,6 +189,7 @@ typedef struct MIContext {
     int scd_method;
     int scene_changed;
     av_pixelutils_sad_fn sad;
+    av_pixelutils_sad_fn block_sad[6];
     double prev_mafd;
     double scd_threshold;
 
@@ -197,6 +198,13 @@ typedef struct MIContext {
     int nb_planes;
 } MIContext;
 
+typedef struct ThreadData {
+    Block *blocks;
+    AVFrame *avf_out;
+    int dir;
+    int alpha;
+} ThreadData;
+
 #define OFFSET(x) offsetof(MIContext, x)
 #define FLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
 #define CONST(name, help, val, unit) { name, help, 0, AV_OPT_TYPE_CONST, {.i64=val}, 0, 0, FLAGS, unit }
@@ -255,6 +263,23 @@ static int query_formats(AVFilterContext *ctx)
     return ff_set_common_formats(ctx, fmts_list);
 }
 
+static uint64_t block_sad(MIContext *mi_ctx, const uint8_t *src1, const uint8_t *src2,
+                          ptrdiff_t linesize, int size)
+{
+    int log2_size = av_log2(size);
+    uint64_t sad = 0;
+    int i, j;
+
+    if (size == 1 << log2_size && mi_ctx->block_sad[log2_size])
+        return mi_ctx->block_sad[log2_size](src1, linesize, src2, linesize);
+
+    for (j = 0; j < size; j++)
+        for (i = 0; i < size; i++)
+            sad += FFABS(src1[i + j * linesize] - src2[i + j * linesize]);
+
+    return sad;
+}
+
 static uint64_t get_sbad(AVMotionEstContext *me_ctx, int x, int y, int x_mv, int y_mv)
 {
     uint8_t *data_cur = me_ctx->data_cur;
@@ -262,8 +287,8 @@ static uint64_t get_sbad(AVMotionEstContext *me_ctx, int x, int y, int x_mv, int
     int linesize = me_ctx->linesize;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    uint64_t sbad;
 
     x = av_clip(x, me_ctx->x_min, me_ctx->x_max);
     y = av_clip(y, me_ctx->y_min, me_ctx->y_max);
@@ -273,9 +298,8 @@ static uint64_t get_sbad(AVMotionEstContext *me_ctx, int x, int y, int x_mv, int
     data_cur += (y + mv_y) * linesize;
     data_next += (y - mv_y) * linesize;
 
-    for (j = 0; j < me_ctx->mb_size; j++)
-        for (i = 0; i < me_ctx->mb_size; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + j * linesize] - data_next[x - mv_x + i + j * linesize]);
+    sbad = block_sad(me_ctx->opaque, data_cur + x + mv_x, data_next + x - mv_x,
+                     linesize, me_ctx->mb_size);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -291,17 +315,19 @@ static uint64_t get_sbad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv,
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    int start = -me_ctx->mb_size / 2;
+    uint64_t sbad;
 
     x = av_clip(x, x_min, x_max);
     y = av_clip(y, y_min, y_max);
     mv_x = av_clip(x_mv - x, -FFMIN(x - x_min, x_max - x), FFMIN(x - x_min, x_max - x));
     mv_y = av_clip(y_mv - y, -FFMIN(y - y_min, y_max - y), FFMIN(y - y_min, y_max - y));
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + (y + mv_y + j) * linesize] - data_next[x - mv_x + i + (y - mv_y + j) * linesize]);
+    sbad = block_sad(me_ctx->opaque,
+                     data_cur  + x + mv_x + start + (y + mv_y + start) * linesize,
+                     data_next + x - mv_x + start + (y - mv_y + start) * linesize,
+                     linesize, me_ctx->mb_size * 3 / 2 - start);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -317,17 +343,18 @@ static uint64_t get_sad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv, i
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
     int mv_x = x_mv - x;
     int mv_y = y_mv - y;
-    int i, j;
-    uint64_t sad = 0;
+    int start = -me_ctx->mb_size / 2;
+    uint64_t sad;
 
     x = av_clip(x, x_min, x_max);
     y = av_clip(y, y_min, y_max);
     x_mv = av_clip(x_mv, x_min, x_max);
     y_mv = av_clip(y_mv, y_min, y_max);
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sad += FFABS(data_ref[x_mv + i + (y_mv + j) * linesize] - data_cur[x + i + (y + j) * linesize]);
+    sad = block_sad(me_ctx->opaque,
+                    data_ref + x_mv + start + (y_mv + start) * linesize,
+                    data_cur + x    + start + (y    + start) * linesize,
+                    linesize, me_ctx->mb_size * 3 / 2 - start);
 
     return sad + (FFABS(mv_x - me_ctx->pred_x) + FFABS(mv_y - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -388,7 +415,11 @@ static int config_input(AVFilterLink *inlink)
             return AVERROR(EINVAL);
     }
 
+    for (i = 1; i < FF_ARRAY_ELEMS(mi_ctx->block_sad); i++)
+        mi_ctx->block_sad[i] = av_pixelutils_get_sad_fn(i, i, 0, mi_ctx);
+
     ff_me_init_context(me_ctx, mi_ctx->mb_size, mi_ctx->search_param, width, height, 0, (mi_ctx->b_width - 1) << mi_ctx->log2_mb_size, 0, (mi_ctx->b_height - 1) << mi_ctx->log2_mb_size);
+    me_ctx->opaque = mi_ctx;
 
     if (mi_ctx->me_mode == ME_MODE_BIDIR)
         me_ctx->get_cost = &get_sad_ob;
@@ -422,9 +453,8 @@ static int config_output(AVFilterLink *outlink)
         preds.nb++;\
     } while(0)
 
-static void search_mv(MIContext *mi_ctx, Block *blocks, int mb_x, int mb_y, int dir)
+static void search_mv(MIContext *mi_ctx, AVMotionEstContext *me_ctx, Block *blocks, int mb_x, int mb_y, int dir)
 {
-    AVMotionEstContext *me_ctx = &mi_ctx->me_ctx;
     AVMotionEstPredictor *preds = me_ctx->preds;
     Block *block = &blocks[mb_x + mb_y * mi_ctx->b_width];
 
@@ -564,8 +594,48 @@ static void search_mv(MIContext *mi_ctx, Block *blocks, int mb_x, int mb_y, int
     block->mvs[dir][1] = mv[1] - y_mb;
 }
 
-static void bilateral_me(MIContext *mi_ctx)
+static int search_mv_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    AVMotionEstContext me_ctx = mi_ctx->me_ctx;
+    const int slice_start = (mi_ctx->b_height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (mi_ctx->b_height * (jobnr + 1)) / nb_jobs;
+    int mb_x, mb_y;
+
+    for (mb_y = slice_start; mb_y < slice_end; mb_y++)
+        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
+            search_mv(mi_ctx, &me_ctx, td->blocks, mb_x, mb_y, td->dir);
+
+    emms_c();
+    return 0;
+}
+
+static void search_mvs(AVFilterContext *ctx, Block *blocks, int dir)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData td;
+    int mb_x, mb_y;
+
+    /* EPZS and UMH predict from the blocks already searched in the current
+     * frame, so they have to run in raster order */
+    if (mi_ctx->me_method == AV_ME_METHOD_EPZS || mi_ctx->me_method == AV_ME_METHOD_UMH) {
+        for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
+            for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
+                search_mv(mi_ctx, &mi_ctx->me_ctx, blocks, mb_x, mb_y, dir);
+        emms_c();
+        return;
+    }
+
+    td.blocks = blocks;
+    td.dir    = dir;
+    ctx->internal->execute(ctx, search_mv_slice, &td, NULL,
+                           FFMIN(mi_ctx->b_height, ff_filter_get_nb_threads(ctx)));
+}
+
+static void bilateral_me(AVFilterContext *ctx)
 {
+    MIContext *mi_ctx = ctx->priv;
     Block *block;
     int mb_x, mb_y;
 
@@ -580,9 +650,27 @@ static void bilateral_me(MIContext *mi_ctx)
             block->mvs[0][1] = 0;
         }
 
-    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
-            search_mv(mi_ctx, mi_ctx->int_blocks, mb_x, mb_y, 0);
+    search_mvs(ctx, mi_ctx->int_blocks, 0);
+}
+
+static int get_sbad_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    const int slice_start = (mi_ctx->b_height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (mi_ctx->b_height * (jobnr + 1)) / nb_jobs;
+    int mb_x, mb_y;
+
+    for (mb_y = slice_start; mb_y < slice_end; mb_y++)
+        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
+            int x_mb = mb_x << mi_ctx->log2_mb_size;
+            int y_mb = mb_y << mi_ctx->log2_mb_size;
+            Block *block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
+
+            block->sbad = get_sbad(&mi_ctx->me_ctx, x_mb, y_mb, x_mb + block->mvs[0][0], y_mb + block->mvs[0][1]);
+        }
+
+    emms_c();
+    return 0;
 }
 
 static int var_size_bme(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n)
@@ -742,7 +830,7 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
     AVFilterContext *ctx = inlink->dst;
     MIContext *mi_ctx = ctx->priv;
     Frame frame_tmp;
-    int mb_x, mb_y, dir;
+    int dir;
 
     av_frame_free(&mi_ctx->frames[0].avf);
     frame_tmp = mi_ctx->frames[0];
@@ -765,9 +853,7 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
                     mi_ctx->me_ctx.data_cur = mi_ctx->frames[2].avf->data[0];
                     mi_ctx->me_ctx.data_ref = mi_ctx->frames[dir ? 3 : 1].avf->data[0];
 
-                    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
-                            search_mv(mi_ctx, mi_ctx->frames[2].blocks, mb_x, mb_y, dir);
+                    search_mvs(ctx, mi_ctx->frames[2].blocks, dir);
                 }
             }
 
@@ -782,21 +868,14 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
             mi_ctx->me_ctx.data_cur = mi_ctx->frames[1].avf->data[0];
             mi_ctx->me_ctx.data_ref = mi_ctx->frames[2].avf->data[0];
 
-            bilateral_me(mi_ctx);
+            bilateral_me(ctx);
 
-            if (mi_ctx->mc_mode == MC_MODE_AOBMC) {
-
-                for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                    for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
-                        int x_mb = mb_x << mi_ctx->log2_mb_size;
-                        int y_mb = mb_y << mi_ctx->log2_mb_size;
-                        block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
-
-                        block->sbad = get_sbad(&mi_ctx->me_ctx, x_mb, y_mb, x_mb + block->mvs[0][0], y_mb + block->mvs[0][1]);
-                    }
-            }
+            if (mi_ctx->mc_mode == MC_MODE_AOBMC)
+                ctx->internal->execute(ctx, get_sbad_slice, NULL, NULL,
+                                       FFMIN(mi_ctx->b_height, ff_filter_get_nb_threads(ctx)));
 
             if (mi_ctx->vsbmc) {
+                int mb_x, mb_y;
 
                 for (i = 0; i < NB_CLUSTERS; i++) {
                     mi_ctx->clusters[i].sum[0] = 0;
@@ -814,7 +893,9 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
 
                 mi_ctx->clusters[0].nb = mi_ctx->b_count;
 
-                if (ret = cluster_mvs(mi_ctx))
+                ret = cluster_mvs(mi_ctx);
+                emms_c();
+                if (ret)
                     return ret;
             }
         }
@@ -867,17 +948,13 @@ static int detect_scene_change(MIContext *mi_ctx)
         pixel_refs->nb++;\
     } while(0)
 
-static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
+static void bidirectional_obmc(MIContext *mi_ctx, int alpha, int slice_start, int slice_end)
 {
     int x, y;
     int width = mi_ctx->frames[0].avf->width;
     int height = mi_ctx->frames[0].avf->height;
     int mb_y, mb_x, dir;
 
-    for (y = 0; y < height; y++)
-        for (x = 0; x < width; x++)
-            mi_ctx->pixel_refs[x + y * width].nb = 0;
-
     for (dir = 0; dir < 2; dir++)
         for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
             for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
@@ -891,9 +968,9 @@ static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
                 start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2 + mv_y * a / ALPHA_MAX;
 
                 startc_x = av_clip(start_x, 0, width - 1);
-                startc_y = av_clip(start_y, 0, height - 1);
+                startc_y = av_clip(start_y, slice_start, slice_end);
                 endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
-                endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1);
+                endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), slice_start, FFMIN(slice_end, height - 1));
 
                 if (dir) {
                     mv_x = -mv_x;
@@ -917,16 +994,15 @@ static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
             }
 }
 
-static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out)
+static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out, int slice_start, int slice_end)
 {
     int x, y, plane;
 
     for (plane = 0; plane < mi_ctx->nb_planes; plane++) {
         int width = avf_out->width;
-        int height = avf_out->height;
         int chroma = plane == 1 || plane == 2;
 
-        for (y = 0; y < height; y++)
+        for (y = slice_start; y < slice_end; y++)
             for (x = 0; x < width; x++) {
                 int x_mv, y_mv;
                 int weight_sum = 0;
@@ -975,7 +1051,8 @@ static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out)
     }
 }
 
-static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n, int alpha)
+static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n, int alpha,
+                         int slice_start, int slice_end)
 {
     int sb_x, sb_y;
     int width = mi_ctx->frames[0].avf->width;
@@ -986,16 +1063,17 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
             Block *sb = &block->subs[sb_x + sb_y * 2];
 
             if (sb->sb)
-                var_size_bmc(mi_ctx, sb, x_mb + (sb_x << (n - 1)), y_mb + (sb_y << (n - 1)), n - 1, alpha);
+                var_size_bmc(mi_ctx, sb, x_mb + (sb_x << (n - 1)), y_mb + (sb_y << (n - 1)), n - 1, alpha,
+                             slice_start, slice_end);
             else {
                 int x, y;
                 int mv_x = sb->mvs[0][0] * 2;
                 int mv_y = sb->mvs[0][1] * 2;
 
                 int start_x = x_mb + (sb_x << (n - 1));
-                int start_y = y_mb + (sb_y << (n - 1));
+                int start_y = FFMAX(y_mb + (sb_y << (n - 1)), slice_start);
                 int end_x = start_x + (1 << (n - 1));
-                int end_y = start_y + (1 << (n - 1));
+                int end_y = FFMIN(y_mb + (sb_y << (n - 1)) + (1 << (n - 1)), slice_end);
 
                 for (y = start_y; y < end_y; y++)  {
                     int y_min = -y;
@@ -1014,7 +1092,8 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
         }
 }
 
-static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y, int alpha)
+static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y, int alpha,
+                           int slice_start, int slice_end)
 {
     int x, y;
     int width = mi_ctx->frames[0].avf->width;
@@ -1029,6 +1108,17 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
     int start_x, start_y;
     int startc_x, startc_y, endc_x, endc_y;
 
+    start_x = (mb_x << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
+    start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
+
+    startc_x = av_clip(start_x, 0, width - 1);
+    startc_y = av_clip(start_y, slice_start, slice_end);
+    endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
+    endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), slice_start, FFMIN(slice_end, height - 1));
+
+    if (startc_y >= endc_y)
+        return;
+
     if (mi_ctx->mc_mode == MC_MODE_AOBMC)
         for (nb_y = FFMAX(0, mb_y - 1); nb_y < FFMIN(mb_y + 2, mi_ctx->b_height); nb_y++)
             for (nb_x = FFMAX(0, mb_x - 1); nb_x < FFMIN(mb_x + 2, mi_ctx->b_width); nb_x++) {
@@ -1039,14 +1129,6 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
                     sbads[nb_x - mb_x + 1 + (nb_y - mb_y + 1) * 3] = get_sbad(&mi_ctx->me_ctx, x_nb, y_nb, x_nb + block->mvs[0][0], y_nb + block->mvs[0][1]);
             }
 
-    start_x = (mb_x << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
-    start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
-
-    startc_x = av_clip(start_x, 0, width - 1);
-    startc_y = av_clip(start_y, 0, height - 1);
-    endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
-    endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1);
-
     for (y = startc_y; y < endc_y; y++) {
         int y_min = -y;
         int y_max = height - y - 1;
@@ -1078,6 +1160,48 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
     }
 }
 
+static int mc_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *avf_out = td->avf_out;
+    const int width  = avf_out->width;
+    const int height = avf_out->height;
+    /* slices are aligned on the chroma subsampling, so that every chroma
+     * sample is written by only one job */
+    const int rows = AV_CEIL_RSHIFT(height, mi_ctx->log2_chroma_h);
+    const int slice_start = ((rows *  jobnr     ) / nb_jobs) << mi_ctx->log2_chroma_h;
+    const int slice_end   = FFMIN(((rows * (jobnr + 1)) / nb_jobs) << mi_ctx->log2_chroma_h, height);
+    int x, y;
+
+    for (y = slice_start; y < slice_end; y++)
+        for (x = 0; x < width; x++)
+            mi_ctx->pixel_refs[x + y * width].nb = 0;
+
+    if (mi_ctx->me_mode == ME_MODE_BIDIR) {
+        bidirectional_obmc(mi_ctx, td->alpha, slice_start, slice_end);
+    } else if (mi_ctx->me_mode == ME_MODE_BILAT) {
+        int mb_x, mb_y;
+        Block *block;
+
+        for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
+            for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
+                block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
+
+                if (block->sb)
+                    var_size_bmc(mi_ctx, block, mb_x << mi_ctx->log2_mb_size, mb_y << mi_ctx->log2_mb_size, mi_ctx->log2_mb_size, td->alpha,
+                                 slice_start, slice_end);
+
+                bilateral_obmc(mi_ctx, block, mb_x, mb_y, td->alpha, slice_start, slice_end);
+            }
+    }
+
+    set_frame_data(mi_ctx, td->alpha, avf_out, slice_start, slice_end);
+
+    emms_c();
+    return 0;
+}
+
 static void interpolate(AVFilterLink *inlink, AVFrame *avf_out)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -1129,34 +1253,17 @@ static void interpolate(AVFilterLink *inlink, AVFrame *avf_out)
             }
 
             break;
-        case MI_MODE_MCI:
-            if (mi_ctx->me_mode == ME_MODE_BIDIR) {
-                bidirectional_obmc(mi_ctx, alpha);
-                set_frame_data(mi_ctx, alpha, avf_out);
+        case MI_MODE_MCI: {
+            ThreadData td;
 
-            } else if (mi_ctx->me_mode == ME_MODE_BILAT) {
-                int mb_x, mb_y;
-                Block *block;
-
-                for (y = 0; y < mi_ctx->frames[0].avf->height; y++)
-                    for (x = 0; x < mi_ctx->frames[0].avf->width; x++)
-                        mi_ctx->pixel_refs[x + y * mi_ctx->frames[0].avf->width].nb = 0;
-
-                for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                    for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
-                        block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
-
-                        if (block->sb)
-                            var_size_bmc(mi_ctx, block, mb_x << mi_ctx->log2_mb_size, mb_y << mi_ctx->log2_mb_size, mi_ctx->log2_mb_size, alpha);
-
-                        bilateral_obmc(mi_ctx, block, mb_x, mb_y, alpha);
-
-                    }
-
-                set_frame_data(mi_ctx, alpha, avf_out);
-            }
+            td.avf_out = avf_out;
+            td.alpha   = alpha;
+            ctx->internal->execute(ctx, mc_slice, &td, NULL,
+                                   FFMIN(AV_CEIL_RSHIFT(avf_out->height, mi_ctx->log2_chroma_h),
+                                         ff_filter_get_nb_threads(ctx)));
 
             break;
+        }
     }
 }
 
@@ -1269,4 +1376,5 @@ AVFilter ff_vf_minterpolate = {
     .query_formats = query_formats,
     .inputs        = minterpolate_inputs,
     .outputs       = minterpolate_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -363,7 +363,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             return AVERROR(ENOMEM);
         }
 
-        av_frame_copy_props(out, in);
+        av_frame_copy_props_shared(out, in);
     } else {
         int i;
 
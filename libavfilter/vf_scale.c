@@ -51,6 +51,8 @@ typedef struct ScaleContext {
     const AVClass *class;
     struct SwsContext *sws;     ///< software scaler context
     struct SwsContext *isws[2]; ///< software scaler context for interlaced material
+    struct SwsContext **slice_sws; ///< software scaler contexts for slices scaled in parallel
+    int nb_slice_sws;
     AVDictionary *opts;
 
     /**
@@ -65,6 +67,7 @@ typedef struct ScaleContext {
     double param[2];            // sws params
 
     int hsub, vsub;             ///< chroma subsampling
+    int out_vsub;               ///< output vertical chroma subsampling
     int slice_y;                ///< top of current output slice
     int input_is_pal;           ///< set to 1 if the input format is paletted
     int output_is_pal;          ///< set to 1 if the output format is paletted
@@ -145,6 +148,16 @@ static av_cold int init_dict(AVFilterContext *ctx, AVDictionary **opts)
     return 0;
 }
 
+static void free_slice_contexts(ScaleContext *scale)
+{
+    int i;
+
+    for (i = 0; i < scale->nb_slice_sws; i++)
+        sws_freeContext(scale->slice_sws[i]);
+    av_freep(&scale->slice_sws);
+    scale->nb_slice_sws = 0;
+}
+
 static av_cold void uninit(AVFilterContext *ctx)
 {
     ScaleContext *scale = ctx->priv;
@@ -152,6 +165,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     sws_freeContext(scale->isws[0]);
     sws_freeContext(scale->isws[1]);
     scale->sws = NULL;
+    free_slice_contexts(scale);
     av_dict_free(&scale->opts);
 }
 
@@ -217,6 +231,124 @@ static const int *parse_yuv_type(const char *s, enum AVColorSpace colorspace)
     return sws_getCoefficients(colorspace);
 }
 
+/* Slices scaled in parallel start on multiples of this many lines, so that
+ * the ordered dither matrices and the alpha blending checkerboard keep the
+ * same phase as when the whole picture is scaled at once. */
+#define SLICE_ALIGN 64
+
+static void get_slice_bounds(int h, int nb_slices, int jobnr,
+                             int *slice_start, int *slice_end)
+{
+    *slice_start = (h *  jobnr     ) / nb_slices & ~(SLICE_ALIGN - 1);
+    *slice_end   = jobnr == nb_slices - 1 ? h :
+                   (h * (jobnr + 1)) / nb_slices & ~(SLICE_ALIGN - 1);
+}
+
+static int init_sws_context(AVFilterContext *ctx, struct SwsContext **s,
+                            AVFilterLink *inlink0, AVFilterLink *outlink,
+                            enum AVPixelFormat outfmt, int src_h, int dst_h,
+                            int field)
+{
+    ScaleContext *scale = ctx->priv;
+    int in_v_chr_pos = scale->in_v_chr_pos, out_v_chr_pos = scale->out_v_chr_pos;
+    int ret;
+
+    *s = sws_alloc_context();
+    if (!*s)
+        return AVERROR(ENOMEM);
+
+    av_opt_set_int(*s, "srcw", inlink0 ->w, 0);
+    av_opt_set_int(*s, "srch", src_h, 0);
+    av_opt_set_int(*s, "src_format", inlink0->format, 0);
+    av_opt_set_int(*s, "dstw", outlink->w, 0);
+    av_opt_set_int(*s, "dsth", dst_h, 0);
+    av_opt_set_int(*s, "dst_format", outfmt, 0);
+    av_opt_set_int(*s, "sws_flags", scale->flags, 0);
+    av_opt_set_int(*s, "param0", scale->param[0], 0);
+    av_opt_set_int(*s, "param1", scale->param[1], 0);
+    if (scale->in_range != AVCOL_RANGE_UNSPECIFIED)
+        av_opt_set_int(*s, "src_range",
+                       scale->in_range == AVCOL_RANGE_JPEG, 0);
+    if (scale->out_range != AVCOL_RANGE_UNSPECIFIED)
+        av_opt_set_int(*s, "dst_range",
+                       scale->out_range == AVCOL_RANGE_JPEG, 0);
+
+    if (scale->opts) {
+        AVDictionaryEntry *e = NULL;
+        while ((e = av_dict_get(scale->opts, "", e, AV_DICT_IGNORE_SUFFIX))) {
+            if ((ret = av_opt_set(*s, e->key, e->value, 0)) < 0)
+                return ret;
+        }
+    }
+    /* Override YUV420P default settings to have the correct (MPEG-2) chroma positions
+     * MPEG-2 chroma positions are used by convention
+     * XXX: support other 4:2:0 pixel formats */
+    if (inlink0->format == AV_PIX_FMT_YUV420P && scale->in_v_chr_pos == -513) {
+        in_v_chr_pos = (field == 0) ? 128 : (field == 1) ? 64 : 192;
+    }
+
+    if (outlink->format == AV_PIX_FMT_YUV420P && scale->out_v_chr_pos == -513) {
+        out_v_chr_pos = (field == 0) ? 128 : (field == 1) ? 64 : 192;
+    }
+
+    av_opt_set_int(*s, "src_h_chr_pos", scale->in_h_chr_pos, 0);
+    av_opt_set_int(*s, "src_v_chr_pos", in_v_chr_pos, 0);
+    av_opt_set_int(*s, "dst_h_chr_pos", scale->out_h_chr_pos, 0);
+    av_opt_set_int(*s, "dst_v_chr_pos", out_v_chr_pos, 0);
+
+    return sws_init_context(*s, NULL, NULL);
+}
+
+/**
+ * Check whether horizontal bands of the picture can be scaled independently
+ * with the same result as the whole picture. This is the case when nothing
+ * is resampled vertically, neither luma nor chroma, and the dithering does
+ * not carry state from one line to the next.
+ *
+ * libswscale writes the last two lines of a picture, and so of each band,
+ * with its C output functions. With a single vertical tap, planar output
+ * goes through yuv2plane1(), whose SIMD versions match the C one exactly;
+ * the packed output functions do not, so packed output is excluded.
+ *
+ * Vertical scaling is not threaded: the filter positions of libswscale are
+ * computed for the whole picture, and it cannot start scaling in the middle
+ * of it, so bands would not reproduce the single-threaded output.
+ */
+static int slice_threads_supported(AVFilterContext *ctx, AVFilterLink *inlink0,
+                                   AVFilterLink *outlink, enum AVPixelFormat outfmt)
+{
+    static const char *const line_dithers[] = { "ed", "a_dither", "x_dither" };
+    ScaleContext *scale = ctx->priv;
+    const AVPixFmtDescriptor *out_desc = av_pix_fmt_desc_get(outfmt);
+    int in_v_chr_pos  = scale->in_v_chr_pos;
+    int out_v_chr_pos = scale->out_v_chr_pos;
+    int64_t dither;
+    int i;
+
+    if (scale->interlaced > 0 || inlink0->h != outlink->h ||
+        av_pix_fmt_desc_get(inlink0->format)->log2_chroma_h != scale->out_vsub)
+        return 0;
+    if (!(out_desc->flags & AV_PIX_FMT_FLAG_PLANAR) && out_desc->nb_components > 1)
+        return 0;
+
+    if (inlink0->format == AV_PIX_FMT_YUV420P && in_v_chr_pos == -513)
+        in_v_chr_pos = 128;
+    if (outlink->format == AV_PIX_FMT_YUV420P && out_v_chr_pos == -513)
+        out_v_chr_pos = 128;
+    if (in_v_chr_pos != out_v_chr_pos)
+        return 0;
+
+    if (av_opt_get_int(scale->sws, "sws_dither", 0, &dither) < 0)
+        return 0;
+    for (i = 0; i < FF_ARRAY_ELEMS(line_dithers); i++) {
+        const AVOption *o = av_opt_find(scale->sws, line_dithers[i], "sws_dither", 0, 0);
+        if (!o || o->default_val.i64 == dither)
+            return 0;
+    }
+
+    return 1;
+}
+
 static int config_props(AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
@@ -273,6 +405,8 @@ static int config_props(AVFilterLink *outlink)
     if (scale->isws[1])
         sws_freeContext(scale->isws[1]);
     scale->isws[0] = scale->isws[1] = scale->sws = NULL;
+    free_slice_contexts(scale);
+    scale->out_vsub = av_pix_fmt_desc_get(outfmt)->log2_chroma_h;
     if (inlink0->w == outlink->w &&
         inlink0->h == outlink->h &&
         !scale->out_color_matrix &&
@@ -281,59 +415,34 @@ static int config_props(AVFilterLink *outlink)
         ;
     else {
         struct SwsContext **swscs[3] = {&scale->sws, &scale->isws[0], &scale->isws[1]};
-        int i;
+        int i, nb_slice_sws;
 
         for (i = 0; i < 3; i++) {
-            int in_v_chr_pos = scale->in_v_chr_pos, out_v_chr_pos = scale->out_v_chr_pos;
-            struct SwsContext **s = swscs[i];
-            *s = sws_alloc_context();
-            if (!*s)
-                return AVERROR(ENOMEM);
-
-            av_opt_set_int(*s, "srcw", inlink0 ->w, 0);
-            av_opt_set_int(*s, "srch", inlink0 ->h >> !!i, 0);
-            av_opt_set_int(*s, "src_format", inlink0->format, 0);
-            av_opt_set_int(*s, "dstw", outlink->w, 0);
-            av_opt_set_int(*s, "dsth", outlink->h >> !!i, 0);
-            av_opt_set_int(*s, "dst_format", outfmt, 0);
-            av_opt_set_int(*s, "sws_flags", scale->flags, 0);
-            av_opt_set_int(*s, "param0", scale->param[0], 0);
-            av_opt_set_int(*s, "param1", scale->param[1], 0);
-            if (scale->in_range != AVCOL_RANGE_UNSPECIFIED)
-                av_opt_set_int(*s, "src_range",
-                               scale->in_range == AVCOL_RANGE_JPEG, 0);
-            if (scale->out_range != AVCOL_RANGE_UNSPECIFIED)
-                av_opt_set_int(*s, "dst_range",
-                               scale->out_range == AVCOL_RANGE_JPEG, 0);
-
-            if (scale->opts) {
-                AVDictionaryEntry *e = NULL;
-                while ((e = av_dict_get(scale->opts, "", e, AV_DICT_IGNORE_SUFFIX))) {
-                    if ((ret = av_opt_set(*s, e->key, e->value, 0)) < 0)
-                        return ret;
-                }
-            }
-            /* Override YUV420P default settings to have the correct (MPEG-2) chroma positions
-             * MPEG-2 chroma positions are used by convention
-             * XXX: support other 4:2:0 pixel formats */
-            if (inlink0->format == AV_PIX_FMT_YUV420P && scale->in_v_chr_pos == -513) {
-                in_v_chr_pos = (i == 0) ? 128 : (i == 1) ? 64 : 192;
-            }
-
-            if (outlink->format == AV_PIX_FMT_YUV420P && scale->out_v_chr_pos == -513) {
-                out_v_chr_pos = (i == 0) ? 128 : (i == 1) ? 64 : 192;
-            }
-
-            av_opt_set_int(*s, "src_h_chr_pos", scale->in_h_chr_pos, 0);
-            av_opt_set_int(*s, "src_v_chr_pos", in_v_chr_pos, 0);
-            av_opt_set_int(*s, "dst_h_chr_pos", scale->out_h_chr_pos, 0);
-            av_opt_set_int(*s, "dst_v_chr_pos", out_v_chr_pos, 0);
-
-            if ((ret = sws_init_context(*s, NULL, NULL)) < 0)
+            ret = init_sws_context(ctx, swscs[i], inlink0, outlink, outfmt,
+                                   inlink0->h >> !!i, outlink->h >> !!i, i);
+            if (ret < 0)
                 return ret;
             if (!scale->interlaced)
                 break;
         }
+
+        nb_slice_sws = slice_threads_supported(ctx, inlink0, outlink, outfmt) ?
+                       FFMIN(ff_filter_get_nb_threads(ctx), outlink->h / SLICE_ALIGN) : 0;
+        if (nb_slice_sws > 1) {
+            scale->slice_sws = av_mallocz_array(nb_slice_sws, sizeof(*scale->slice_sws));
+            if (!scale->slice_sws)
+                return AVERROR(ENOMEM);
+            scale->nb_slice_sws = nb_slice_sws;
+            for (i = 0; i < nb_slice_sws; i++) {
+                int slice_start, slice_end;
+
+                get_slice_bounds(outlink->h, nb_slice_sws, i, &slice_start, &slice_end);
+                ret = init_sws_context(ctx, &scale->slice_sws[i], inlink0, outlink, outfmt,
+                                       slice_end - slice_start, slice_end - slice_start, 0);
+                if (ret < 0)
+                    return ret;
+            }
+        }
     }
 
     if (inlink0->sample_aspect_ratio.num){
@@ -400,12 +509,54 @@ static int scale_slice(AVFilterLink *link, AVFrame *out_buf, AVFrame *cur_pic, s
                          out,out_stride);
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+} ThreadData;
+
+static int scale_field(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ScaleContext *scale = ctx->priv;
+    AVFilterLink *link = ctx->inputs[0];
+    ThreadData *td = arg;
+
+    scale_slice(link, td->out, td->in, scale->isws[jobnr], 0,
+                (link->h + !jobnr) / 2, 2, jobnr);
+    return 0;
+}
+
+static int scale_band(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ScaleContext *scale = ctx->priv;
+    ThreadData *td = arg;
+    const uint8_t *in[4];
+    uint8_t *out[4];
+    int i, slice_start, slice_end;
+
+    get_slice_bounds(td->out->height, nb_jobs, jobnr, &slice_start, &slice_end);
+
+    for (i = 0; i < 4; i++) {
+        int in_vsub  = ((i+1)&2) ? scale->vsub     : 0;
+        int out_vsub = ((i+1)&2) ? scale->out_vsub : 0;
+         in[i] = td->in ->data[i] + (slice_start >>  in_vsub) * td->in ->linesize[i];
+        out[i] = td->out->data[i] + (slice_start >> out_vsub) * td->out->linesize[i];
+    }
+    if (scale->input_is_pal)
+         in[1] = td->in->data[1];
+    if (scale->output_is_pal)
+        out[1] = td->out->data[1];
+
+    sws_scale(scale->slice_sws[jobnr], in, td->in->linesize, 0, slice_end - slice_start,
+              out, td->out->linesize);
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *link, AVFrame *in)
 {
     ScaleContext *scale = link->dst->priv;
     AVFilterLink *outlink = link->dst->outputs[0];
     AVFrame *out;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
+    ThreadData td;
     char buf[32];
     int in_range;
 
@@ -449,7 +600,7 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         return AVERROR(ENOMEM);
     }
 
-    av_frame_copy_props(out, in);
+    av_frame_copy_props_shared(out, in);
     out->width  = outlink->w;
     out->height = outlink->h;
 
@@ -463,7 +614,7 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         || scale-> in_range != AVCOL_RANGE_UNSPECIFIED
         || in_range != AVCOL_RANGE_UNSPECIFIED
         || scale->out_range != AVCOL_RANGE_UNSPECIFIED) {
-        int in_full, out_full, brightness, contrast, saturation;
+        int i, in_full, out_full, brightness, contrast, saturation;
         const int *inv_table, *table;
 
         sws_getColorspaceDetails(scale->sws, (int **)&inv_table, &in_full,
@@ -495,6 +646,10 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
             sws_setColorspaceDetails(scale->isws[1], inv_table, in_full,
                                      table, out_full,
                                      brightness, contrast, saturation);
+        for (i = 0; i < scale->nb_slice_sws; i++)
+            sws_setColorspaceDetails(scale->slice_sws[i], inv_table, in_full,
+                                     table, out_full,
+                                     brightness, contrast, saturation);
 
         out->color_range = out_full ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
     }
@@ -504,9 +659,10 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
               (int64_t)in->sample_aspect_ratio.den * outlink->w * link->h,
               INT_MAX);
 
+    td.in  = in;
+    td.out = out;
     if(scale->interlaced>0 || (scale->interlaced<0 && in->interlaced_frame)){
-        scale_slice(link, out, in, scale->isws[0], 0, (link->h+1)/2, 2, 0);
-        scale_slice(link, out, in, scale->isws[1], 0,  link->h   /2, 2, 1);
+        link->dst->internal->execute(link->dst, scale_field, &td, NULL, 2);
     }else if (scale->nb_slices) {
         int i, slice_h, slice_start, slice_end = 0;
         const int nb_slices = FFMIN(scale->nb_slices, link->h);
@@ -516,6 +672,8 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
             slice_h     = slice_end - slice_start;
             scale_slice(link, out, in, scale->sws, slice_start, slice_h, 1, 0);
         }
+    }else if (scale->nb_slice_sws) {
+        link->dst->internal->execute(link->dst, scale_band, &td, NULL, scale->nb_slice_sws);
     }else{
         scale_slice(link, out, in, scale->sws, 0, link->h, 1, 0);
     }
@@ -639,6 +797,7 @@ AVFilter ff_vf_scale = {
     .inputs          = avfilter_vf_scale_inputs,
     .outputs         = avfilter_vf_scale_outputs,
     .process_command = process_command,
+    .flags           = AVFILTER_FLAG_SLICE_THREADS,
 };
 
 static const AVClass scale2ref_class = {
@@ -691,4 +850,5 @@ AVFilter ff_vf_scale2ref = {
     .inputs          = avfilter_vf_scale2ref_inputs,
     .outputs         = avfilter_vf_scale2ref_outputs,
     .process_command = process_command,
+    .flags           = AVFILTER_FLAG_SLICE_THREADS,
 };
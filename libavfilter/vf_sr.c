@@ -94,6 +94,7 @@ static av_cold int init(AVFilterContext *context)
         av_log(context, AV_LOG_ERROR, "could not load DNN model\n");
         return AVERROR(EIO);
     }
+    sr_context->model->filter_ctx = context;
 
     sr_context->sws_contexts[0] = NULL;
     sr_context->sws_contexts[1] = NULL;
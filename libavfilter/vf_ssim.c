@@ -59,16 +59,25 @@ typedef struct SSIMContext {
     uint8_t rgba_map[4];
     int planewidth[4];
     int planeheight[4];
-    int *temp;
+    int nb_threads;
+    int **temp;
+    float *score[4];
     int is_rgb;
-    float (*ssim_plane)(SSIMDSPContext *dsp,
-                        uint8_t *main, int main_stride,
-                        uint8_t *ref, int ref_stride,
-                        int width, int height, void *temp,
-                        int max);
+    void (*ssim_plane)(SSIMDSPContext *dsp,
+                       uint8_t *main, int main_stride,
+                       uint8_t *ref, int ref_stride,
+                       int width, void *temp, int max,
+                       float *score, int slice_start, int slice_end);
     SSIMDSPContext dsp;
 } SSIMContext;
 
+typedef struct ThreadData {
+    uint8_t *main_data[4];
+    uint8_t *ref_data[4];
+    int main_linesize[4];
+    int ref_linesize[4];
+} ThreadData;
+
 #define OFFSET(x) offsetof(SSIMContext, x)
 #define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
 
@@ -221,21 +230,23 @@ static float ssim_endn_8bit(const int (*sum0)[4], const int (*sum1)[4], int widt
 
 #define SUM_LEN(w) (((w) >> 2) + 3)
 
-static float ssim_plane_16bit(SSIMDSPContext *dsp,
-                              uint8_t *main, int main_stride,
-                              uint8_t *ref, int ref_stride,
-                              int width, int height, void *temp,
-                              int max)
+/* Compute the SSIM of the rows of 4x4 blocks slice_start to slice_end - 1,
+ * each one together with the row above it. The per-row results are summed
+ * by the caller in raster order, so the result does not depend on the
+ * number of slices. */
+static void ssim_plane_16bit(SSIMDSPContext *dsp,
+                             uint8_t *main, int main_stride,
+                             uint8_t *ref, int ref_stride,
+                             int width, void *temp, int max,
+                             float *score, int slice_start, int slice_end)
 {
-    int z = 0, y;
-    float ssim = 0.0;
+    int z = slice_start - 1, y;
     int64_t (*sum0)[4] = temp;
     int64_t (*sum1)[4] = sum0 + SUM_LEN(width);
 
     width >>= 2;
-    height >>= 2;
 
-    for (y = 1; y < height; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         for (; z <= y; z++) {
             FFSWAP(void*, sum0, sum1);
             ssim_4x4xn_16bit(&main[4 * z * main_stride], main_stride,
@@ -243,27 +254,23 @@ static float ssim_plane_16bit(SSIMDSPContext *dsp,
                              sum0, width);
         }
 
-        ssim += ssim_endn_16bit((const int64_t (*)[4])sum0, (const int64_t (*)[4])sum1, width - 1, max);
+        score[y] = ssim_endn_16bit((const int64_t (*)[4])sum0, (const int64_t (*)[4])sum1, width - 1, max);
     }
-
-    return ssim / ((height - 1) * (width - 1));
 }
 
-static float ssim_plane(SSIMDSPContext *dsp,
-                        uint8_t *main, int main_stride,
-                        uint8_t *ref, int ref_stride,
-                        int width, int height, void *temp,
-                        int max)
+static void ssim_plane(SSIMDSPContext *dsp,
+                       uint8_t *main, int main_stride,
+                       uint8_t *ref, int ref_stride,
+                       int width, void *temp, int max,
+                       float *score, int slice_start, int slice_end)
 {
-    int z = 0, y;
-    float ssim = 0.0;
+    int z = slice_start - 1, y;
     int (*sum0)[4] = temp;
     int (*sum1)[4] = sum0 + SUM_LEN(width);
 
     width >>= 2;
-    height >>= 2;
 
-    for (y = 1; y < height; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         for (; z <= y; z++) {
             FFSWAP(void*, sum0, sum1);
             dsp->ssim_4x4_line(&main[4 * z * main_stride], main_stride,
@@ -271,10 +278,28 @@ static float ssim_plane(SSIMDSPContext *dsp,
                                sum0, width);
         }
 
-        ssim += dsp->ssim_end_line((const int (*)[4])sum0, (const int (*)[4])sum1, width - 1);
+        score[y] = dsp->ssim_end_line((const int (*)[4])sum0, (const int (*)[4])sum1, width - 1);
+    }
+}
+
+static int ssim_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    SSIMContext *s = ctx->priv;
+    ThreadData *td = arg;
+    int i;
+
+    for (i = 0; i < s->nb_components; i++) {
+        const int height = s->planeheight[i] >> 2;
+        const int slice_start = 1 + ((height - 1) *  jobnr     ) / nb_jobs;
+        const int slice_end   = 1 + ((height - 1) * (jobnr + 1)) / nb_jobs;
+
+        s->ssim_plane(&s->dsp, td->main_data[i], td->main_linesize[i],
+                      td->ref_data[i], td->ref_linesize[i],
+                      s->planewidth[i], s->temp[jobnr], s->max,
+                      s->score[i], slice_start, slice_end);
     }
 
-    return ssim / ((height - 1) * (width - 1));
+    return 0;
 }
 
 static double ssim_db(double ssim, double weight)
@@ -288,8 +313,9 @@ static int do_ssim(FFFrameSync *fs)
     SSIMContext *s = ctx->priv;
     AVFrame *master, *ref;
     AVDictionary **metadata;
+    ThreadData td;
     float c[4], ssimv = 0.0;
-    int ret, i;
+    int ret, i, y;
 
     ret = ff_framesync_dualinput_get(fs, &master, &ref);
     if (ret < 0)
@@ -301,10 +327,23 @@ static int do_ssim(FFFrameSync *fs)
     s->nb_frames++;
 
     for (i = 0; i < s->nb_components; i++) {
-        c[i] = s->ssim_plane(&s->dsp, master->data[i], master->linesize[i],
-                             ref->data[i], ref->linesize[i],
-                             s->planewidth[i], s->planeheight[i], s->temp,
-                             s->max);
+        td.main_data[i]     = master->data[i];
+        td.main_linesize[i] = master->linesize[i];
+        td.ref_data[i]      = ref->data[i];
+        td.ref_linesize[i]  = ref->linesize[i];
+    }
+
+    ctx->internal->execute(ctx, ssim_slice, &td, NULL,
+                           av_clip((s->planeheight[0] >> 2) - 1, 1, s->nb_threads));
+
+    for (i = 0; i < s->nb_components; i++) {
+        const int width  = s->planewidth[i]  >> 2;
+        const int height = s->planeheight[i] >> 2;
+        float ssim = 0.0;
+
+        for (y = 1; y < height; y++)
+            ssim += s->score[i][y];
+        c[i] = ssim / ((height - 1) * (width - 1));
         ssimv += s->coefs[i] * c[i];
         s->ssim[i] += c[i];
     }
@@ -410,9 +449,20 @@ static int config_input_ref(AVFilterLink *inlink)
     for (i = 0; i < s->nb_components; i++)
         s->coefs[i] = (double) s->planeheight[i] * s->planewidth[i] / sum;
 
-    s->temp = av_mallocz_array(2 * SUM_LEN(inlink->w), (desc->comp[0].depth > 8) ? sizeof(int64_t[4]) : sizeof(int[4]));
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->temp = av_mallocz_array(s->nb_threads, sizeof(*s->temp));
     if (!s->temp)
         return AVERROR(ENOMEM);
+    for (i = 0; i < s->nb_threads; i++) {
+        s->temp[i] = av_mallocz_array(2 * SUM_LEN(inlink->w), (desc->comp[0].depth > 8) ? sizeof(int64_t[4]) : sizeof(int[4]));
+        if (!s->temp[i])
+            return AVERROR(ENOMEM);
+    }
+    for (i = 0; i < s->nb_components; i++) {
+        s->score[i] = av_mallocz_array(FFMAX(s->planeheight[i] >> 2, 1), sizeof(*s->score[i]));
+        if (!s->score[i])
+            return AVERROR(ENOMEM);
+    }
     s->max = (1 << desc->comp[0].depth) - 1;
 
     s->ssim_plane = desc->comp[0].depth > 8 ? ssim_plane_16bit : ssim_plane;
@@ -455,10 +505,10 @@ static int activate(AVFilterContext *ctx)
 static av_cold void uninit(AVFilterContext *ctx)
 {
     SSIMContext *s = ctx->priv;
+    int i;
 
     if (s->nb_frames > 0) {
         char buf[256];
-        int i;
         buf[0] = 0;
         for (i = 0; i < s->nb_components; i++) {
             int c = s->is_rgb ? s->rgba_map[i] : i;
@@ -474,7 +524,12 @@ static av_cold void uninit(AVFilterContext *ctx)
     if (s->stats_file && s->stats_file != stdout)
         fclose(s->stats_file);
 
+    if (s->temp)
+        for (i = 0; i < s->nb_threads; i++)
+            av_freep(&s->temp[i]);
     av_freep(&s->temp);
+    for (i = 0; i < 4; i++)
+        av_freep(&s->score[i]);
 }
 
 static const AVFilterPad ssim_inputs[] = {
@@ -510,4 +565,5 @@ AVFilter ff_vf_ssim = {
     .priv_class    = &ssim_class,
     .inputs        = ssim_inputs,
     .outputs       = ssim_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
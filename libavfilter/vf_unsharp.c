@@ -47,11 +47,21 @@
 #include "libavutil/pixdesc.h"
 #include "unsharp.h"
 
-static void apply_unsharp(      uint8_t *dst, int dst_stride,
-                          const uint8_t *src, int src_stride,
-                          int width, int height, UnsharpFilterParam *fp)
+typedef struct ThreadData {
+    UnsharpFilterParam *fp;
+    uint8_t       *dst;
+    const uint8_t *src;
+    int dst_stride;
+    int src_stride;
+    int width;
+    int height;
+} ThreadData;
+
+static int unsharp_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    uint32_t **sc = fp->sc;
+    ThreadData *td = arg;
+    UnsharpFilterParam *fp = td->fp;
+    uint32_t **sc = fp->sc + jobnr * 2 * fp->steps_y;
     uint32_t sr[MAX_MATRIX_SIZE - 1], tmp1, tmp2;
 
     int32_t res;
@@ -62,16 +72,34 @@ static void apply_unsharp(      uint8_t *dst, int dst_stride,
     const int steps_y = fp->steps_y;
     const int scalebits = fp->scalebits;
     const int32_t halfscale = fp->halfscale;
+    const int width  = td->width;
+    const int height = td->height;
+    const int dst_stride = td->dst_stride;
+    const int src_stride = td->src_stride;
+    const int slice_start = (height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (height * (jobnr + 1)) / nb_jobs;
+    uint8_t *dst = td->dst;
+    const uint8_t *src = td->src;
 
     if (!amount) {
-        av_image_copy_plane(dst, dst_stride, src, src_stride, width, height);
-        return;
+        av_image_copy_plane(dst + slice_start * dst_stride, dst_stride,
+                            src + slice_start * src_stride, src_stride,
+                            width, slice_end - slice_start);
+        return 0;
     }
 
     for (y = 0; y < 2 * steps_y; y++)
         memset(sc[y], 0, sizeof(sc[y][0]) * (width + 2 * steps_x));
 
-    for (y = -steps_y; y < height + steps_y; y++) {
+    /* The state machine is a finite impulse response of 2 * steps_y + 1
+     * rows, so starting steps_y rows above the slice gives the same
+     * result as running it over the whole plane. */
+    if (slice_start > steps_y) {
+        src += (slice_start - steps_y) * src_stride;
+        dst += (slice_start - steps_y) * dst_stride;
+    }
+
+    for (y = slice_start - steps_y; y < slice_end + steps_y; y++) {
         if (y < height)
             src2 = src;
 
@@ -86,7 +114,7 @@ static void apply_unsharp(      uint8_t *dst, int dst_stride,
                 tmp2 = sc[z + 0][x + steps_x] + tmp1; sc[z + 0][x + steps_x] = tmp1;
                 tmp1 = sc[z + 1][x + steps_x] + tmp2; sc[z + 1][x + steps_x] = tmp2;
             }
-            if (x >= steps_x && y >= steps_y) {
+            if (x >= steps_x && y >= slice_start + steps_y) {
                 const uint8_t *srx = src - steps_y * src_stride + x - steps_x;
                 uint8_t *dsx       = dst - steps_y * dst_stride + x - steps_x;
 
@@ -99,6 +127,7 @@ static void apply_unsharp(      uint8_t *dst, int dst_stride,
             src += src_stride;
         }
     }
+    return 0;
 }
 
 static int apply_unsharp_c(AVFilterContext *ctx, AVFrame *in, AVFrame *out)
@@ -107,6 +136,8 @@ static int apply_unsharp_c(AVFilterContext *ctx, AVFrame *in, AVFrame *out)
     UnsharpContext *s = ctx->priv;
     int i, plane_w[3], plane_h[3];
     UnsharpFilterParam *fp[3];
+    ThreadData td;
+
     plane_w[0] = inlink->w;
     plane_w[1] = plane_w[2] = AV_CEIL_RSHIFT(inlink->w, s->hsub);
     plane_h[0] = inlink->h;
@@ -114,7 +145,15 @@ static int apply_unsharp_c(AVFilterContext *ctx, AVFrame *in, AVFrame *out)
     fp[0] = &s->luma;
     fp[1] = fp[2] = &s->chroma;
     for (i = 0; i < 3; i++) {
-        apply_unsharp(out->data[i], out->linesize[i], in->data[i], in->linesize[i], plane_w[i], plane_h[i], fp[i]);
+        td.fp = fp[i];
+        td.dst = out->data[i];
+        td.src = in->data[i];
+        td.dst_stride = out->linesize[i];
+        td.src_stride = in->linesize[i];
+        td.width  = plane_w[i];
+        td.height = plane_h[i];
+        ctx->internal->execute(ctx, unsharp_slice, &td, NULL,
+                               FFMIN(plane_h[i], s->nb_threads));
     }
     return 0;
 }
@@ -162,6 +201,7 @@ static int query_formats(AVFilterContext *ctx)
 
 static int init_filter_param(AVFilterContext *ctx, UnsharpFilterParam *fp, const char *effect_type, int width)
 {
+    UnsharpContext *s = ctx->priv;
     int z;
     const char *effect = fp->amount == 0 ? "none" : fp->amount < 0 ? "blur" : "sharpen";
 
@@ -175,7 +215,11 @@ static int init_filter_param(AVFilterContext *ctx, UnsharpFilterParam *fp, const
     av_log(ctx, AV_LOG_VERBOSE, "effect:%s type:%s msize_x:%d msize_y:%d amount:%0.2f\n",
            effect, effect_type, fp->msize_x, fp->msize_y, fp->amount / 65535.0);
 
-    for (z = 0; z < 2 * fp->steps_y; z++)
+    fp->sc = av_mallocz_array(2 * fp->steps_y * s->nb_threads, sizeof(uint32_t *));
+    if (!fp->sc)
+        return AVERROR(ENOMEM);
+
+    for (z = 0; z < 2 * fp->steps_y * s->nb_threads; z++)
         if (!(fp->sc[z] = av_malloc_array(width + 2 * fp->steps_x,
                                           sizeof(*(fp->sc[z])))))
             return AVERROR(ENOMEM);
@@ -191,6 +235,7 @@ static int config_props(AVFilterLink *link)
 
     s->hsub = desc->log2_chroma_w;
     s->vsub = desc->log2_chroma_h;
+    s->nb_threads = ff_filter_get_nb_threads(link->dst);
 
     ret = init_filter_param(link->dst, &s->luma,   "luma",   link->w);
     if (ret < 0)
@@ -202,20 +247,24 @@ static int config_props(AVFilterLink *link)
     return 0;
 }
 
-static void free_filter_param(UnsharpFilterParam *fp)
+static void free_filter_param(UnsharpFilterParam *fp, int nb_threads)
 {
     int z;
 
-    for (z = 0; z < 2 * fp->steps_y; z++)
+    if (!fp->sc)
+        return;
+
+    for (z = 0; z < 2 * fp->steps_y * nb_threads; z++)
         av_freep(&fp->sc[z]);
+    av_freep(&fp->sc);
 }
 
 static av_cold void uninit(AVFilterContext *ctx)
 {
     UnsharpContext *s = ctx->priv;
 
-    free_filter_param(&s->luma);
-    free_filter_param(&s->chroma);
+    free_filter_param(&s->luma, s->nb_threads);
+    free_filter_param(&s->chroma, s->nb_threads);
 }
 
 static int filter_frame(AVFilterLink *link, AVFrame *in)
@@ -294,5 +343,5 @@ AVFilter ff_vf_unsharp = {
     .query_formats = query_formats,
     .inputs        = avfilter_vf_unsharp_inputs,
     .outputs       = avfilter_vf_unsharp_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -1944,6 +1944,19 @@ typedef struct AVFormatContext {
      * - decoding: set by user
      */
     int skip_estimate_duration_from_pts;
+
+    /**
+     * Account charged with the packet buffers allocated by
+     * avformat_find_stream_info(), av_read_frame() and
+     * av_interleaved_write_frame(), see AVBufferAccount. When its limit is
+     * reached, these functions fail with AVERROR(ENOMEM).
+     *
+     * If unset, the buffers are charged to the account current in the
+     * calling thread, if any.
+     *
+     * Set and owned by the user.
+     */
+    AVBufferAccount *buffer_account;
 } AVFormatContext;
 
 #if FF_API_FORMAT_GET_SET
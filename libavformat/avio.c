@@ -23,6 +23,7 @@
 #include "libavutil/dict.h"
 #include "libavutil/opt.h"
 #include "libavutil/time.h"
+#include "libavutil/trace.h"
 #include "libavutil/avassert.h"
 #include "os_support.h"
 #include "avformat.h"
@@ -363,7 +364,8 @@ static inline int retry_transfer_wrapper(URLContext *h, uint8_t *buf,
                                          int size, int size_min,
                                          int (*transfer_func)(URLContext *h,
                                                               uint8_t *buf,
-                                                              int size))
+                                                              int size),
+                                         const char *trace_category)
 {
     int ret, len;
     int fast_retries = 5;
@@ -373,7 +375,9 @@ static inline int retry_transfer_wrapper(URLContext *h, uint8_t *buf,
     while (len < size_min) {
         if (ff_check_interrupt(&h->interrupt_callback))
             return AVERROR_EXIT;
+        av_trace_begin(trace_category, h->prot->name);
         ret = transfer_func(h, buf + len, size - len);
+        av_trace_end();
         if (ret == AVERROR(EINTR))
             continue;
         if (h->flags & AVIO_FLAG_NONBLOCK)
@@ -408,14 +412,14 @@ int ffurl_read(URLContext *h, unsigned char *buf, int size)
 {
     if (!(h->flags & AVIO_FLAG_READ))
         return AVERROR(EIO);
-    return retry_transfer_wrapper(h, buf, size, 1, h->prot->url_read);
+    return retry_transfer_wrapper(h, buf, size, 1, h->prot->url_read, "ffurl_read");
 }
 
 int ffurl_read_complete(URLContext *h, unsigned char *buf, int size)
 {
     if (!(h->flags & AVIO_FLAG_READ))
         return AVERROR(EIO);
-    return retry_transfer_wrapper(h, buf, size, size, h->prot->url_read);
+    return retry_transfer_wrapper(h, buf, size, size, h->prot->url_read, "ffurl_read");
 }
 
 int ffurl_write(URLContext *h, const unsigned char *buf, int size)
@@ -428,7 +432,7 @@ int ffurl_write(URLContext *h, const unsigned char *buf, int size)
 
     return retry_transfer_wrapper(h, (unsigned char *)buf, size, size,
                                   (int (*)(struct URLContext *, uint8_t *, int))
-                                  h->prot->url_write);
+                                  h->prot->url_write, "ffurl_write");
 }
 
 int64_t ffurl_seek(URLContext *h, int64_t pos, int whence)
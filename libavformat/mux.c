@@ -36,6 +36,7 @@
 #include "libavutil/mathematics.h"
 #include "libavutil/parseutils.h"
 #include "libavutil/time.h"
+#include "libavutil/trace.h"
 #include "riff.h"
 #include "audiointerleave.h"
 #include "url.h"
@@ -1182,7 +1183,7 @@ static int interleave_packet(AVFormatContext *s, AVPacket *out, AVPacket *in, in
         return ff_interleave_packet_per_dts(s, out, in, flush);
 }
 
-int av_interleaved_write_frame(AVFormatContext *s, AVPacket *pkt)
+static int interleaved_write_frame(AVFormatContext *s, AVPacket *pkt)
 {
     int ret, flush = 0;
 
@@ -1244,6 +1245,19 @@ fail:
     return ret;
 }
 
+int av_interleaved_write_frame(AVFormatContext *s, AVPacket *pkt)
+{
+    AVBufferAccount *prev_account = av_buffer_account_enter(s->buffer_account);
+    int ret;
+
+    av_trace_begin("av_interleaved_write_frame", s->oformat->name);
+    ret = interleaved_write_frame(s, pkt);
+    av_trace_end();
+    av_buffer_account_leave(prev_account);
+
+    return ret;
+}
+
 int av_write_trailer(AVFormatContext *s)
 {
     int ret, i;
@@ -1764,7 +1764,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
     return ret;
 }
 
-int av_read_frame(AVFormatContext *s, AVPacket *pkt)
+static int read_frame(AVFormatContext *s, AVPacket *pkt)
 {
     const int genpts = s->flags & AVFMT_FLAG_GENPTS;
     int eof = 0;
@@ -1861,6 +1861,15 @@ return_packet:
     return ret;
 }
 
+int av_read_frame(AVFormatContext *s, AVPacket *pkt)
+{
+    AVBufferAccount *prev_account = av_buffer_account_enter(s->buffer_account);
+    int ret = read_frame(s, pkt);
+
+    av_buffer_account_leave(prev_account);
+    return ret;
+}
+
 /* XXX: suppress the packet queue */
 static void flush_packet_queue(AVFormatContext *s)
 {
@@ -3562,7 +3571,7 @@ static int extract_extradata(AVStream *st, AVPacket *pkt)
     return 0;
 }
 
-int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
+static int find_stream_info(AVFormatContext *ic, AVDictionary **options)
 {
     int i, count = 0, ret = 0, j;
     int64_t read_size;
@@ -4164,6 +4173,15 @@ find_stream_info_err:
     return ret;
 }
 
+int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
+{
+    AVBufferAccount *prev_account = av_buffer_account_enter(ic->buffer_account);
+    int ret = find_stream_info(ic, options);
+
+    av_buffer_account_leave(prev_account);
+    return ret;
+}
+
 AVProgram *av_find_program_from_stream(AVFormatContext *ic, AVProgram *last, int s)
 {
     int i, j;
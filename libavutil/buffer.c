@@ -20,37 +20,200 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "config.h"
 #include "buffer_internal.h"
 #include "common.h"
+#include "error.h"
 #include "mem.h"
 #include "thread.h"
 
-AVBufferRef *av_buffer_create(uint8_t *data, int size,
-                              void (*free)(void *opaque, uint8_t *data),
-                              void *opaque, int flags)
+static AVOnce account_once = AV_ONCE_INIT;
+/* set once the current accounts can be looked up, so that buffers can be
+ * allocated without touching thread-local storage if accounts are unused */
+static atomic_int account_used = ATOMIC_VAR_INIT(0);
+
+#if HAVE_PTHREADS
+static pthread_key_t account_key;
+
+static void account_init(void)
 {
-    AVBufferRef *ref = NULL;
-    AVBuffer    *buf = NULL;
+    if (!pthread_key_create(&account_key, NULL))
+        atomic_store(&account_used, 1);
+}
 
-    buf = av_mallocz(sizeof(*buf));
-    if (!buf)
+#define get_current_account()   ((AVBufferAccount *)pthread_getspecific(account_key))
+#define set_current_account(a)  pthread_setspecific(account_key, a)
+#elif !HAVE_THREADS
+static AVBufferAccount *cur_account;
+
+static void account_init(void)
+{
+    atomic_store(&account_used, 1);
+}
+
+#define get_current_account()   cur_account
+#define set_current_account(a)  (cur_account = (a))
+#else
+/* no thread-local storage, accounts are never current */
+static void account_init(void)
+{
+}
+
+#define get_current_account()   NULL
+#define set_current_account(a)  ((void)(a))
+#endif
+
+static AVBufferAccount *current_account(void)
+{
+    if (!atomic_load_explicit(&account_used, memory_order_relaxed))
         return NULL;
+    return get_current_account();
+}
+
+AVBufferAccount *av_buffer_account_alloc(void)
+{
+    AVBufferAccount *account;
+
+    ff_thread_once(&account_once, account_init);
+
+    account = av_mallocz(sizeof(*account));
+    if (!account)
+        return NULL;
+
+    ff_mutex_init(&account->mutex, NULL);
+    atomic_init(&account->refcount, 1);
+
+    return account;
+}
+
+static void account_unref(AVBufferAccount *account)
+{
+    if (atomic_fetch_add_explicit(&account->refcount, -1, memory_order_acq_rel) == 1) {
+        ff_mutex_destroy(&account->mutex);
+        av_free(account);
+    }
+}
+
+void av_buffer_account_free(AVBufferAccount **paccount)
+{
+    if (!paccount || !*paccount)
+        return;
+
+    account_unref(*paccount);
+    *paccount = NULL;
+}
+
+void av_buffer_account_set_limit(AVBufferAccount *account, int64_t limit)
+{
+    ff_mutex_lock(&account->mutex);
+    account->limit = FFMAX(limit, 0);
+    ff_mutex_unlock(&account->mutex);
+}
+
+int64_t av_buffer_account_get_usage(AVBufferAccount *account, int64_t *peak)
+{
+    int64_t usage;
+
+    ff_mutex_lock(&account->mutex);
+    usage = account->usage;
+    if (peak)
+        *peak = account->peak;
+    ff_mutex_unlock(&account->mutex);
+
+    return usage;
+}
+
+AVBufferAccount *av_buffer_account_enter(AVBufferAccount *account)
+{
+    AVBufferAccount *prev = current_account();
+
+    if (account)
+        set_current_account(account);
+
+    return prev;
+}
+
+void av_buffer_account_leave(AVBufferAccount *prev)
+{
+    if (atomic_load_explicit(&account_used, memory_order_relaxed))
+        set_current_account(prev);
+}
+
+/* add size bytes (which may be negative) to the usage, only growing the
+ * usage is subject to the limit */
+static int account_charge(AVBufferAccount *account, int64_t size)
+{
+    int ret = 0;
+
+    ff_mutex_lock(&account->mutex);
+    if (size > 0 && account->limit && account->usage + size > account->limit) {
+        ret = AVERROR(ENOMEM);
+    } else {
+        account->usage += size;
+        account->peak   = FFMAX(account->peak, account->usage);
+    }
+    ff_mutex_unlock(&account->mutex);
+
+    return ret;
+}
+
+/* charge a new buffer of the given size to the current account, if any */
+static int buffer_charge(AVBufferAccount **paccount, int size)
+{
+    AVBufferAccount *account = current_account();
+
+    *paccount = NULL;
+    if (size < 0)
+        return AVERROR(EINVAL);
+    if (!account)
+        return 0;
+    if (account_charge(account, size) < 0)
+        return AVERROR(ENOMEM);
+
+    atomic_fetch_add_explicit(&account->refcount, 1, memory_order_relaxed);
+    *paccount = account;
+    return 0;
+}
+
+static void buffer_discharge(AVBufferAccount *account, int size)
+{
+    if (!account)
+        return;
+
+    account_charge(account, -(int64_t)size);
+    account_unref(account);
+}
+
+int ff_buffer_charge(AVBufferRef *buf)
+{
+    AVBuffer *b = buf->buffer;
+
+    if (b->account)
+        return 0;
+    return buffer_charge(&b->account, b->size);
+}
+
+static AVBufferRef *buffer_create(AVBuffer *buf, uint8_t *data, int size,
+                                  void (*free)(void *opaque, uint8_t *data),
+                                  void *opaque, int flags)
+{
+    AVBufferRef *ref = NULL;
 
     buf->data     = data;
     buf->size     = size;
     buf->free     = free ? free : av_buffer_default_free;
     buf->opaque   = opaque;
+    buf->account  = NULL;
 
     atomic_init(&buf->refcount, 1);
 
+    buf->flags = 0;
     if (flags & AV_BUFFER_FLAG_READONLY)
         buf->flags |= BUFFER_FLAG_READONLY;
 
     ref = av_mallocz(sizeof(*ref));
-    if (!ref) {
-        av_freep(&buf);
+    if (!ref)
         return NULL;
-    }
 
     ref->buffer = buf;
     ref->data   = data;
@@ -59,6 +222,23 @@ AVBufferRef *av_buffer_create(uint8_t *data, int size,
     return ref;
 }
 
+AVBufferRef *av_buffer_create(uint8_t *data, int size,
+                              void (*free)(void *opaque, uint8_t *data),
+                              void *opaque, int flags)
+{
+    AVBufferRef *ret;
+    AVBuffer *buf = av_mallocz(sizeof(*buf));
+    if (!buf)
+        return NULL;
+
+    ret = buffer_create(buf, data, size, free, opaque, flags);
+    if (!ret) {
+        av_free(buf);
+        return NULL;
+    }
+    return ret;
+}
+
 void av_buffer_default_free(void *opaque, uint8_t *data)
 {
     av_free(data);
@@ -66,18 +246,27 @@ void av_buffer_default_free(void *opaque, uint8_t *data)
 
 AVBufferRef *av_buffer_alloc(int size)
 {
+    AVBufferAccount *account;
     AVBufferRef *ret = NULL;
     uint8_t    *data = NULL;
 
+    if (buffer_charge(&account, size) < 0)
+        return NULL;
+
     data = av_malloc(size);
     if (!data)
-        return NULL;
+        goto fail;
 
     ret = av_buffer_create(data, size, av_buffer_default_free, NULL, 0);
     if (!ret)
-        av_freep(&data);
+        goto fail;
 
+    ret->buffer->account = account;
     return ret;
+fail:
+    av_freep(&data);
+    buffer_discharge(account, size);
+    return NULL;
 }
 
 AVBufferRef *av_buffer_allocz(int size)
@@ -117,8 +306,16 @@ static void buffer_replace(AVBufferRef **dst, AVBufferRef **src)
         av_freep(dst);
 
     if (atomic_fetch_add_explicit(&b->refcount, -1, memory_order_acq_rel) == 1) {
+        /* b->free below might already free the structure containing *b,
+         * so we have to read the flag now to avoid use-after-free. */
+        int free_avbuffer = !(b->flags & BUFFER_FLAG_NO_FREE);
+        AVBufferAccount *account = b->account;
+        int size = b->size;
+
         b->free(b->opaque, b->data);
-        av_freep(&b);
+        if (free_avbuffer)
+            av_free(b);
+        buffer_discharge(account, size);
     }
 }
 
@@ -169,22 +366,32 @@ int av_buffer_make_writable(AVBufferRef **pbuf)
 int av_buffer_realloc(AVBufferRef **pbuf, int size)
 {
     AVBufferRef *buf = *pbuf;
+    AVBufferAccount *account;
     uint8_t *tmp;
 
     if (!buf) {
         /* allocate a new buffer with av_realloc(), so it will be reallocatable
          * later */
-        uint8_t *data = av_realloc(NULL, size);
-        if (!data)
+        uint8_t *data;
+
+        if (buffer_charge(&account, size) < 0)
             return AVERROR(ENOMEM);
 
+        data = av_realloc(NULL, size);
+        if (!data) {
+            buffer_discharge(account, size);
+            return AVERROR(ENOMEM);
+        }
+
         buf = av_buffer_create(data, size, av_buffer_default_free, NULL, 0);
         if (!buf) {
             av_freep(&data);
+            buffer_discharge(account, size);
             return AVERROR(ENOMEM);
         }
 
         buf->buffer->flags |= BUFFER_FLAG_REALLOCATABLE;
+        buf->buffer->account = account;
         *pbuf = buf;
 
         return 0;
@@ -206,9 +413,16 @@ int av_buffer_realloc(AVBufferRef **pbuf, int size)
         return 0;
     }
 
+    account = buf->buffer->account;
+    if (account && account_charge(account, size - (int64_t)buf->size) < 0)
+        return AVERROR(ENOMEM);
+
     tmp = av_realloc(buf->buffer->data, size);
-    if (!tmp)
+    if (!tmp) {
+        if (account)
+            account_charge(account, buf->size - (int64_t)size);
         return AVERROR(ENOMEM);
+    }
 
     buf->buffer->data = buf->data = tmp;
     buf->buffer->size = buf->size = size;
@@ -262,6 +476,7 @@ static void buffer_pool_free(AVBufferPool *pool)
         pool->pool = buf->next;
 
         buf->free(buf->opaque, buf->data);
+        buffer_discharge(buf->account, buf->charged);
         av_freep(&buf);
     }
     ff_mutex_destroy(&pool->mutex);
@@ -325,6 +540,10 @@ static AVBufferRef *pool_alloc_buffer(AVBufferPool *pool)
     buf->free   = ret->buffer->free;
     buf->pool   = pool;
 
+    buf->account         = ret->buffer->account;
+    buf->charged         = ret->buffer->size;
+    ret->buffer->account = NULL;
+
     ret->buffer->opaque = buf;
     ret->buffer->free   = pool_release_buffer;
 
@@ -333,23 +552,35 @@ static AVBufferRef *pool_alloc_buffer(AVBufferPool *pool)
 
 AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
 {
-    AVBufferRef *ret;
+    AVBufferRef *ret = NULL;
     BufferPoolEntry *buf;
 
+    /* Only the list manipulation and the allocation callback, which may
+     * rely on being serialized, are done under the lock. Reusing an entry
+     * needs a single allocation for the AVBufferRef, done outside of it. */
     ff_mutex_lock(&pool->mutex);
     buf = pool->pool;
     if (buf) {
-        ret = av_buffer_create(buf->data, pool->size, pool_release_buffer,
-                               buf, 0);
-        if (ret) {
-            pool->pool = buf->next;
-            buf->next = NULL;
-        }
+        pool->pool = buf->next;
+        buf->next = NULL;
     } else {
         ret = pool_alloc_buffer(pool);
     }
     ff_mutex_unlock(&pool->mutex);
 
+    if (buf) {
+        ret = buffer_create(&buf->buffer, buf->data, pool->size,
+                            pool_release_buffer, buf, 0);
+        if (ret) {
+            buf->buffer.flags |= BUFFER_FLAG_NO_FREE;
+        } else {
+            ff_mutex_lock(&pool->mutex);
+            buf->next = pool->pool;
+            pool->pool = buf;
+            ff_mutex_unlock(&pool->mutex);
+        }
+    }
+
     if (ret)
         atomic_fetch_add_explicit(&pool->refcount, 1, memory_order_relaxed);
 
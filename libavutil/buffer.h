@@ -284,6 +284,92 @@ void av_buffer_pool_uninit(AVBufferPool **pool);
  */
 AVBufferRef *av_buffer_pool_get(AVBufferPool *pool);
 
+/**
+ * @}
+ */
+
+/**
+ * @defgroup lavu_bufferaccount AVBufferAccount
+ * @ingroup lavu_data
+ *
+ * @{
+ * AVBufferAccount tracks how much memory is held in buffers allocated on
+ * behalf of one owner, e.g. a decoder, a demuxer or a filtergraph, and can
+ * optionally cap it.
+ *
+ * Each thread has a current account, set with av_buffer_account_enter().
+ * The data of every buffer allocated by av_buffer_alloc(), av_buffer_allocz()
+ * and av_buffer_realloc() while an account is current is charged to that
+ * account until the buffer is freed. This covers buffers allocated by the
+ * default allocator of an AVBufferPool, which stay charged while they are
+ * kept in the pool, and so most of the memory held in frames and packets.
+ * Frame side data is charged while it is in use, also when its buffer comes
+ * from the pools libavutil shares between all frames. Memory allocated with
+ * av_malloc() directly and buffers wrapping existing data with
+ * av_buffer_create() are not accounted.
+ *
+ * When a charge would take the usage of an account over its limit, the
+ * allocation fails, which the callers report as AVERROR(ENOMEM).
+ *
+ * The libraries make the account of a context (AVCodecContext.buffer_account,
+ * AVFormatContext.buffer_account, AVFilterGraph.buffer_account) current while
+ * they do work for it.
+ *
+ * @note Accounting relies on thread-local storage and is only available when
+ * FFmpeg is built with pthreads or without threading support; otherwise no
+ * account is ever current.
+ */
+
+typedef struct AVBufferAccount AVBufferAccount;
+
+/**
+ * Allocate a new account, with no limit.
+ *
+ * @return the new account, or NULL on failure
+ */
+AVBufferAccount *av_buffer_account_alloc(void);
+
+/**
+ * Free an account. The account only disappears once all the buffers charged
+ * to it are freed, so this may be called while some of them are still in use.
+ * It must not be current on any thread anymore.
+ *
+ * @param account pointer to the account to free, it will be set to NULL
+ */
+void av_buffer_account_free(AVBufferAccount **account);
+
+/**
+ * Set the maximum number of bytes that may be charged to the account.
+ * Lowering the limit below the current usage does not free anything, but
+ * makes further allocations fail until the usage goes back down.
+ *
+ * @param limit the limit in bytes, or 0 for no limit
+ */
+void av_buffer_account_set_limit(AVBufferAccount *account, int64_t limit);
+
+/**
+ * Get the number of bytes currently charged to the account.
+ *
+ * @param peak if not NULL, set to the highest usage seen so far
+ */
+int64_t av_buffer_account_get_usage(AVBufferAccount *account, int64_t *peak);
+
+/**
+ * Make account the current account of the calling thread.
+ *
+ * @param account the account to charge allocations to, or NULL to leave the
+ *                current account unchanged
+ * @return the previously current account, to be restored with
+ *         av_buffer_account_leave()
+ */
+AVBufferAccount *av_buffer_account_enter(AVBufferAccount *account);
+
+/**
+ * Restore the account that was current before the matching call to
+ * av_buffer_account_enter().
+ */
+void av_buffer_account_leave(AVBufferAccount *prev);
+
 /**
  * @}
  */
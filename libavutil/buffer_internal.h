@@ -34,6 +34,12 @@
  */
 #define BUFFER_FLAG_REALLOCATABLE (1 << 1)
 
+/**
+ * The AVBuffer structure is part of a larger structure
+ * and should not be freed.
+ */
+#define BUFFER_FLAG_NO_FREE       (1 << 2)
+
 struct AVBuffer {
     uint8_t *data; /**< data described by this buffer */
     int      size; /**< size of data in bytes */
@@ -57,6 +63,11 @@ struct AVBuffer {
      * A combination of BUFFER_FLAG_*
      */
     int flags;
+
+    /**
+     * the account size bytes are charged to, holding a reference to it
+     */
+    AVBufferAccount *account;
 };
 
 typedef struct BufferPoolEntry {
@@ -71,8 +82,34 @@ typedef struct BufferPoolEntry {
 
     AVBufferPool *pool;
     struct BufferPoolEntry *next;
+
+    /*
+     * The charge of the original AVBuffer, moved here since the data is
+     * now owned by the pool.
+     */
+    AVBufferAccount *account;
+    int charged;
+
+    /*
+     * An AVBuffer structure to (re)use as AVBuffer for subsequent uses
+     * of this BufferPoolEntry, so that getting a buffer from the pool
+     * does not need to allocate one.
+     */
+    AVBuffer buffer;
 } BufferPoolEntry;
 
+struct AVBufferAccount {
+    AVMutex mutex;
+    int64_t usage;
+    int64_t peak;
+    int64_t limit;
+
+    /*
+     * One reference held by the caller and one per charged buffer.
+     */
+    atomic_uint refcount;
+};
+
 struct AVBufferPool {
     AVMutex mutex;
     BufferPoolEntry *pool;
@@ -95,4 +132,13 @@ struct AVBufferPool {
     void         (*pool_free)(void *opaque);
 };
 
+/**
+ * Charge a buffer not allocated by av_buffer_alloc(), e.g. taken from a pool
+ * shared with other owners, to the current account until it is freed.
+ *
+ * @param buf a buffer with a single reference, that is not charged yet
+ * @return 0 on success, AVERROR(ENOMEM) if the account is over its limit
+ */
+int ff_buffer_charge(AVBufferRef *buf);
+
 #endif /* AVUTIL_BUFFER_INTERNAL_H */
@@ -27,11 +27,113 @@
 #include "time_internal.h"
 #include "bprint.h"
 
+/* dictionaries with at least this many entries get a hash index */
+#define DICT_HASH_MIN 16
+
+typedef struct DictSlot {
+    unsigned hash;
+    unsigned index;     ///< index into elems + 1, 0 for an empty slot
+} DictSlot;
+
 struct AVDictionary {
     int count;
     AVDictionaryEntry *elems;
+    /* open addressing table with linear probing, keyed on the case folded
+     * key; only maintained by av_dict_set() so that readers stay const */
+    DictSlot *hash;
+    unsigned hash_size;
 };
 
+static unsigned dict_hash(const char *key)
+{
+    unsigned h = 2166136261U;
+
+    if (key)
+        for (; *key; key++)
+            h = (h ^ av_toupper(*key)) * 16777619U;
+    return h;
+}
+
+static void dict_index_insert(AVDictionary *m, unsigned hash, unsigned idx)
+{
+    unsigned mask = m->hash_size - 1, i;
+
+    for (i = hash & mask; m->hash[i].index; i = (i + 1) & mask)
+        ;
+    m->hash[i].hash  = hash;
+    m->hash[i].index = idx + 1;
+}
+
+static unsigned dict_index_find(const AVDictionary *m, unsigned idx)
+{
+    unsigned mask = m->hash_size - 1, i;
+
+    for (i = dict_hash(m->elems[idx].key) & mask; m->hash[i].index != idx + 1;
+         i = (i + 1) & mask)
+        ;
+    return i;
+}
+
+static void dict_index_remove(AVDictionary *m, unsigned idx)
+{
+    unsigned mask = m->hash_size - 1, i, j, k;
+
+    i = dict_index_find(m, idx);
+    /* shift the rest of the cluster back so that no lookup stops early */
+    for (j = (i + 1) & mask; m->hash[j].index; j = (j + 1) & mask) {
+        k = m->hash[j].hash & mask;
+        if (i <= j ? (k <= i || k > j) : (k <= i && k > j)) {
+            m->hash[i] = m->hash[j];
+            i = j;
+        }
+    }
+    m->hash[i].index = 0;
+}
+
+/* index elems[count - 1], building or growing the table as needed; once
+ * built, the table is kept up to date even if the count drops again */
+static void dict_index_add(AVDictionary *m)
+{
+    unsigned size, i;
+    DictSlot *hash;
+
+    if (!m->hash && m->count < DICT_HASH_MIN)
+        return;
+    if (m->count * 2 <= m->hash_size) {
+        dict_index_insert(m, dict_hash(m->elems[m->count - 1].key), m->count - 1);
+        return;
+    }
+
+    size = FFMAX(m->hash_size * 2, 4 * DICT_HASH_MIN);
+    hash = av_calloc(size, sizeof(*hash));
+    av_freep(&m->hash);
+    m->hash_size = 0;
+    /* the index is only an accelerator, lookups fall back to a scan */
+    if (!hash)
+        return;
+    m->hash      = hash;
+    m->hash_size = size;
+    for (i = 0; i < m->count; i++)
+        dict_index_insert(m, dict_hash(m->elems[i].key), i);
+}
+
+static AVDictionaryEntry *dict_index_get(const AVDictionary *m, const char *key,
+                                         int flags)
+{
+    unsigned mask = m->hash_size - 1, hash = dict_hash(key), best = UINT_MAX, i;
+
+    /* keys differing only in case share a cluster, keep the earliest match */
+    for (i = hash & mask; m->hash[i].index; i = (i + 1) & mask) {
+        const DictSlot *s = &m->hash[i];
+        const char *k = m->elems[s->index - 1].key;
+        if (s->hash != hash || s->index - 1 >= best)
+            continue;
+        if (flags & AV_DICT_MATCH_CASE ? !strcmp(k, key) : !av_strcasecmp(k, key))
+            best = s->index - 1;
+    }
+    return best != UINT_MAX ? &m->elems[best] : NULL;
+}
+
 int av_dict_count(const AVDictionary *m)
 {
     return m ? m->count : 0;
@@ -45,6 +147,9 @@ AVDictionaryEntry *av_dict_get(const AVDictionary *m, const char *key,
     if (!m)
         return NULL;
 
+    if (m->hash && !prev && key && !(flags & AV_DICT_IGNORE_SUFFIX))
+        return dict_index_get(m, key, flags);
+
     if (prev)
         i = prev - m->elems + 1;
     else
@@ -100,6 +205,11 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
             oldval = tag->value;
         else
             av_free(tag->value);
+        if (m->hash) {
+            dict_index_remove(m, tag - m->elems);
+            if (tag != &m->elems[m->count - 1])
+                m->hash[dict_index_find(m, m->count - 1)].index = tag - m->elems + 1;
+        }
         av_free(tag->key);
         *tag = m->elems[--m->count];
     } else if (copy_value) {
@@ -124,11 +234,13 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
             av_freep(&copy_value);
         }
         m->count++;
+        dict_index_add(m);
     } else {
         av_freep(&copy_key);
     }
     if (!m->count) {
         av_freep(&m->elems);
+        av_freep(&m->hash);
         av_freep(pm);
     }
 
@@ -137,6 +249,7 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
 err_out:
     if (m && !m->count) {
         av_freep(&m->elems);
+        av_freep(&m->hash);
         av_freep(pm);
     }
     av_free(copy_key);
@@ -210,6 +323,7 @@ void av_dict_free(AVDictionary **pm)
             av_freep(&m->elems[m->count].value);
         }
         av_freep(&m->elems);
+        av_freep(&m->hash);
     }
     av_freep(pm);
 }
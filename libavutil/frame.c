@@ -16,15 +16,19 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <stdatomic.h>
+
 #include "channel_layout.h"
 #include "avassert.h"
 #include "buffer.h"
+#include "buffer_internal.h"
 #include "common.h"
 #include "dict.h"
 #include "frame.h"
 #include "imgutils.h"
 #include "mem.h"
 #include "samplefmt.h"
+#include "thread.h"
 
 #if FF_API_FRAME_GET_SET
 MAKE_ACCESSORS(AVFrame, frame, int64_t, best_effort_timestamp)
@@ -186,6 +190,78 @@ static void wipe_side_data(AVFrame *frame)
     av_freep(&frame->side_data);
 }
 
+/* Side data is small and allocated for nearly every frame, so it comes from
+ * pools of power of two sizes from 64 bytes to 32 kB. They are created once
+ * and live until av_frame_side_data_pools_uninit(). */
+#define SIDE_DATA_POOLS 10
+
+static atomic_uintptr_t side_data_pools[SIDE_DATA_POOLS];
+static AVOnce side_data_pools_once = AV_ONCE_INIT;
+
+/* the pools are shared by the whole process, so their buffers are not
+ * charged to the AVBufferAccount that happens to be current when they are
+ * first allocated, but to the current one whenever they are handed out */
+static AVBufferRef *side_data_pool_alloc(int size)
+{
+    AVBufferRef *buf;
+    uint8_t *data = av_malloc(size);
+    if (!data)
+        return NULL;
+
+    buf = av_buffer_create(data, size, av_buffer_default_free, NULL, 0);
+    if (!buf)
+        av_free(data);
+    return buf;
+}
+
+static void side_data_pools_init(void)
+{
+    int i;
+
+    for (i = 0; i < SIDE_DATA_POOLS; i++)
+        atomic_init(&side_data_pools[i],
+                    (uintptr_t)av_buffer_pool_init(64 << i, side_data_pool_alloc));
+}
+
+static AVBufferRef *side_data_alloc(int size)
+{
+    AVBufferPool *pool;
+    AVBufferRef *buf;
+    int i;
+
+    if (size < 0 || size > 64 << (SIDE_DATA_POOLS - 1))
+        return av_buffer_alloc(size);
+    for (i = 0; size > 64 << i; i++)
+        ;
+
+    ff_thread_once(&side_data_pools_once, side_data_pools_init);
+    pool = (AVBufferPool *)atomic_load_explicit(&side_data_pools[i],
+                                                memory_order_relaxed);
+    if (!pool)
+        return av_buffer_alloc(size);
+
+    buf = av_buffer_pool_get(pool);
+    if (buf) {
+        buf->size = size;
+        if (ff_buffer_charge(buf) < 0)
+            av_buffer_unref(&buf);
+    }
+    return buf;
+}
+
+void av_frame_side_data_pools_uninit(void)
+{
+    int i;
+
+    /* make sure a later allocation does not create them again */
+    ff_thread_once(&side_data_pools_once, side_data_pools_init);
+
+    for (i = 0; i < SIDE_DATA_POOLS; i++) {
+        AVBufferPool *pool = (AVBufferPool *)atomic_exchange(&side_data_pools[i], 0);
+        av_buffer_pool_uninit(&pool);
+    }
+}
+
 AVFrame *av_frame_alloc(void)
 {
     AVFrame *frame = av_mallocz(sizeof(*frame));
@@ -402,6 +478,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
                 wipe_side_data(dst);
                 return AVERROR(ENOMEM);
             }
+            sd_dst->size = sd_src->size;
         }
         av_dict_copy(&sd_dst->metadata, sd_src->metadata, 0);
     }
@@ -654,6 +731,11 @@ int av_frame_copy_props(AVFrame *dst, const AVFrame *src)
     return frame_copy_props(dst, src, 1);
 }
 
+int av_frame_copy_props_shared(AVFrame *dst, const AVFrame *src)
+{
+    return frame_copy_props(dst, src, 0);
+}
+
 AVBufferRef *av_frame_get_plane_buffer(AVFrame *frame, int plane)
 {
     uint8_t *data;
@@ -722,7 +804,7 @@ AVFrameSideData *av_frame_new_side_data(AVFrame *frame,
                                         int size)
 {
     AVFrameSideData *ret;
-    AVBufferRef *buf = av_buffer_alloc(size);
+    AVBufferRef *buf = side_data_alloc(size);
     ret = av_frame_new_side_data_from_buf(frame, type, buf);
     if (!ret)
         av_buffer_unref(&buf);
@@ -174,6 +174,11 @@ enum AVActiveFormatDescription {
 /**
  * Structure to hold side data for an AVFrame.
  *
+ * The buffer holding the data may be shared with other frames, e.g. after
+ * av_frame_ref() or av_frame_copy_props_shared(). To modify the data of existing
+ * side data, call av_buffer_make_writable() on buf and set data to
+ * buf->data first.
+ *
  * sizeof(AVFrameSideData) is not a part of the public ABI, so new fields may be added
  * to the end with a minor bump.
  */
@@ -795,6 +800,14 @@ int av_frame_copy(AVFrame *dst, const AVFrame *src);
  */
 int av_frame_copy_props(AVFrame *dst, const AVFrame *src);
 
+/**
+ * Like av_frame_copy_props(), but the side data buffers of src are shared
+ * with dst instead of copied, as in av_frame_ref(). Side data of either frame
+ * must then be made writable with av_buffer_make_writable() before it is
+ * modified.
+ */
+int av_frame_copy_props_shared(AVFrame *dst, const AVFrame *src);
+
 /**
  * Get the buffer reference a given data plane is stored in.
  *
@@ -847,6 +860,16 @@ AVFrameSideData *av_frame_get_side_data(const AVFrame *frame,
  */
 void av_frame_remove_side_data(AVFrame *frame, enum AVFrameSideDataType type);
 
+/**
+ * Free the buffer pools small side data is allocated from. Side data still
+ * in use is freed normally later, and side data allocated afterwards does not
+ * use the pools.
+ *
+ * This must not be called while any other thread may allocate frame side
+ * data, e.g. only before the program exits.
+ */
+void av_frame_side_data_pools_uninit(void);
+
 
 /**
  * Flags for frame cropping.
@@ -305,6 +305,43 @@ int av_image_check_sar(unsigned int w, unsigned int h, AVRational sar)
     return AVERROR(EINVAL);
 }
 
+/* planes larger than this are copied with non-temporal stores, if
+ * available, so that the copy does not evict the whole cache */
+#define STREAM_COPY_THRESHOLD (4 << 20)
+
+static void copy_plane_rows(uint8_t       *dst, ptrdiff_t dst_linesize,
+                            const uint8_t *src, ptrdiff_t src_linesize,
+                            ptrdiff_t bytewidth, int height)
+{
+    if (height > 0 && dst_linesize == bytewidth && src_linesize == bytewidth) {
+        memcpy(dst, src, bytewidth * height);
+        return;
+    }
+    for (;height > 0; height--) {
+        memcpy(dst, src, bytewidth);
+        dst += dst_linesize;
+        src += src_linesize;
+    }
+}
+
+static void copy_plane_stream(uint8_t       *dst, ptrdiff_t dst_linesize,
+                              const uint8_t *src, ptrdiff_t src_linesize,
+                              ptrdiff_t bytewidth, int height)
+{
+    int ret = -1;
+
+#if ARCH_X86
+    ret = ff_image_copy_plane_nt_x86(dst, dst_linesize, src, src_linesize,
+                                     bytewidth, height);
+#endif
+
+    if (ret < 0)
+        copy_plane_rows(dst, dst_linesize, src, src_linesize, bytewidth, height);
+    else if (ret < bytewidth)
+        copy_plane_rows(dst + ret, dst_linesize, src + ret, src_linesize,
+                        bytewidth - ret, height);
+}
+
 static void image_copy_plane(uint8_t       *dst, ptrdiff_t dst_linesize,
                              const uint8_t *src, ptrdiff_t src_linesize,
                              ptrdiff_t bytewidth, int height)
@@ -313,11 +350,22 @@ static void image_copy_plane(uint8_t       *dst, ptrdiff_t dst_linesize,
         return;
     av_assert0(abs(src_linesize) >= bytewidth);
     av_assert0(abs(dst_linesize) >= bytewidth);
-    for (;height > 0; height--) {
-        memcpy(dst, src, bytewidth);
-        dst += dst_linesize;
-        src += src_linesize;
-    }
+    if (height > 0 && bytewidth * height >= STREAM_COPY_THRESHOLD)
+        copy_plane_stream(dst, dst_linesize, src, src_linesize, bytewidth, height);
+    else
+        copy_plane_rows(dst, dst_linesize, src, src_linesize, bytewidth, height);
+}
+
+/* for the slices of a large image, which may be below the threshold */
+static void image_copy_plane_stream(uint8_t       *dst, ptrdiff_t dst_linesize,
+                                    const uint8_t *src, ptrdiff_t src_linesize,
+                                    ptrdiff_t bytewidth, int height)
+{
+    if (!dst || !src)
+        return;
+    av_assert0(abs(src_linesize) >= bytewidth);
+    av_assert0(abs(dst_linesize) >= bytewidth);
+    copy_plane_stream(dst, dst_linesize, src, src_linesize, bytewidth, height);
 }
 
 static void image_copy_plane_uc_from(uint8_t       *dst, ptrdiff_t dst_linesize,
@@ -408,6 +456,88 @@ void av_image_copy_uc_from(uint8_t *dst_data[4], const ptrdiff_t dst_linesizes[4
                width, height, image_copy_plane_uc_from);
 }
 
+typedef struct ImageCopyContext {
+    uint8_t **dst_data;
+    const ptrdiff_t *dst_linesizes;
+    const uint8_t **src_data;
+    const ptrdiff_t *src_linesizes;
+    const AVPixFmtDescriptor *desc;
+    enum AVPixelFormat pix_fmt;
+    int width, height;
+    void (*copy_plane)(uint8_t *, ptrdiff_t, const uint8_t *,
+                       ptrdiff_t, ptrdiff_t, int);
+} ImageCopyContext;
+
+static int image_copy_job(void *arg, int jobnr, int nb_jobs)
+{
+    ImageCopyContext *c = arg;
+    /* slices start on a chroma line, so that each one has whole chroma lines */
+    int align = 1 << c->desc->log2_chroma_h;
+    int y0 = FFALIGN((int64_t)c->height *  jobnr      / nb_jobs, align);
+    int y1 = FFALIGN((int64_t)c->height * (jobnr + 1) / nb_jobs, align);
+    uint8_t *dst_data[4] = { NULL };
+    const uint8_t *src_data[4] = { NULL };
+    int i, planes_nb = 0;
+
+    y1 = FFMIN(y1, c->height);
+    if (y0 >= y1)
+        return 0;
+
+    for (i = 0; i < c->desc->nb_components; i++)
+        planes_nb = FFMAX(planes_nb, c->desc->comp[i].plane + 1);
+
+    for (i = 0; i < planes_nb; i++) {
+        int y = (i == 1 || i == 2) ? y0 >> c->desc->log2_chroma_h : y0;
+        dst_data[i] = c->dst_data[i] ? c->dst_data[i] + y * c->dst_linesizes[i] : NULL;
+        src_data[i] = c->src_data[i] ? c->src_data[i] + y * c->src_linesizes[i] : NULL;
+    }
+    image_copy(dst_data, c->dst_linesizes, src_data, c->src_linesizes,
+               c->pix_fmt, c->width, y1 - y0, c->copy_plane);
+    return 0;
+}
+
+void av_image_copy_execute(uint8_t *dst_data[4], const ptrdiff_t dst_linesizes[4],
+                           const uint8_t *src_data[4], const ptrdiff_t src_linesizes[4],
+                           enum AVPixelFormat pix_fmt, int width, int height,
+                           av_image_execute_func *execute, void *opaque, int nb_jobs)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
+    ImageCopyContext c = {
+        .dst_data      = dst_data,
+        .dst_linesizes = dst_linesizes,
+        .src_data      = src_data,
+        .src_linesizes = src_linesizes,
+        .desc          = desc,
+        .pix_fmt       = pix_fmt,
+        .width         = width,
+        .height        = height,
+        .copy_plane    = image_copy_plane,
+    };
+    int i, size = 0;
+
+    if (!desc || desc->flags & AV_PIX_FMT_FLAG_HWACCEL)
+        return;
+
+    /* palettes are not split */
+    if (!execute || nb_jobs <= 1 ||
+        desc->flags & AV_PIX_FMT_FLAG_PAL || desc->flags & FF_PSEUDOPAL) {
+        image_copy(dst_data, dst_linesizes, src_data, src_linesizes, pix_fmt,
+                   width, height, image_copy_plane);
+        return;
+    }
+
+    for (i = 0; i < 4; i++) {
+        int h = (i == 1 || i == 2) ? AV_CEIL_RSHIFT(height, desc->log2_chroma_h) : height;
+        int linesize = av_image_get_linesize(pix_fmt, width, i);
+        if (linesize > 0)
+            size = FFMAX(size, FFMIN((int64_t)linesize * h, INT_MAX));
+    }
+    if (size >= STREAM_COPY_THRESHOLD)
+        c.copy_plane = image_copy_plane_stream;
+
+    execute(opaque, image_copy_job, &c, nb_jobs);
+}
+
 int av_image_fill_arrays(uint8_t *dst_data[4], int dst_linesize[4],
                          const uint8_t *src, enum AVPixelFormat pix_fmt,
                          int width, int height, int align)
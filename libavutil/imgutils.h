@@ -138,6 +138,38 @@ void av_image_copy_uc_from(uint8_t *dst_data[4],       const ptrdiff_t dst_lines
                            const uint8_t *src_data[4], const ptrdiff_t src_linesizes[4],
                            enum AVPixelFormat pix_fmt, int width, int height);
 
+/**
+ * Function copying one slice of an image, passed to an av_image_execute_func.
+ */
+typedef int (av_image_job_func)(void *arg, int jobnr, int nb_jobs);
+
+/**
+ * Function calling func(arg, jobnr, nb_jobs) once for every jobnr from 0 to
+ * nb_jobs - 1, possibly in parallel, and returning once all calls have
+ * finished, e.g. on top of an application thread pool.
+ */
+typedef void (av_image_execute_func)(void *opaque, av_image_job_func *func,
+                                     void *arg, int nb_jobs);
+
+/**
+ * Copy image in src_data to dst_data, split into nb_jobs horizontal slices
+ * that are copied by the given execute function.
+ *
+ * This is worth it for large images, whose copy is bound by the memory
+ * bandwidth of a single core. Images with a palette are copied by the
+ * calling thread, as are all images if execute is NULL or nb_jobs is 1.
+ *
+ * @param dst_linesizes linesizes for the image in dst_data
+ * @param src_linesizes linesizes for the image in src_data
+ * @param execute       function running the slice copies
+ * @param opaque        first argument passed to execute
+ * @param nb_jobs       number of slices to copy
+ */
+void av_image_copy_execute(uint8_t *dst_data[4],       const ptrdiff_t dst_linesizes[4],
+                           const uint8_t *src_data[4], const ptrdiff_t src_linesizes[4],
+                           enum AVPixelFormat pix_fmt, int width, int height,
+                           av_image_execute_func *execute, void *opaque, int nb_jobs);
+
 /**
  * Setup the data pointers and linesizes based on the specified image
  * parameters and the provided array.
@@ -26,5 +26,14 @@ int ff_image_copy_plane_uc_from_x86(uint8_t       *dst, ptrdiff_t dst_linesize,
                                     const uint8_t *src, ptrdiff_t src_linesize,
                                     ptrdiff_t bytewidth, int height);
 
+/**
+ * Copy the start of each line with non-temporal stores.
+ *
+ * @return the number of bytes copied per line, or a negative error code if
+ *         nothing was copied
+ */
+int ff_image_copy_plane_nt_x86(uint8_t       *dst, ptrdiff_t dst_linesize,
+                               const uint8_t *src, ptrdiff_t src_linesize,
+                               ptrdiff_t bytewidth, int height);
 
 #endif /* AVUTIL_IMGUTILS_INTERNAL_H */
@@ -33,6 +33,7 @@
 #include <io.h>
 #endif
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include "avutil.h"
 #include "bprint.h"
@@ -40,6 +41,7 @@
 #include "internal.h"
 #include "log.h"
 #include "thread.h"
+#include "time.h"
 
 static AVMutex mutex = AV_MUTEX_INITIALIZER;
 
@@ -297,28 +299,16 @@ int av_log_format_line2(void *ptr, int level, const char *fmt, va_list vl,
     return ret;
 }
 
-void av_log_default_callback(void* ptr, int level, const char* fmt, va_list vl)
+/* Print one formatted message n times, the parts must be sanitizable. */
+static void log_output(int level, unsigned tint, int print_prefix, int type[2],
+                      char *part[4], int n)
 {
-    static int print_prefix = 1;
     static int count;
     static char prev[LINE_SZ];
-    AVBPrint part[4];
-    char line[LINE_SZ];
     static int is_atty;
-    int type[2];
-    unsigned tint = 0;
-
-    if (level >= 0) {
-        tint = level & 0xff00;
-        level &= 0xff;
-    }
-
-    if (level > av_log_level)
-        return;
-    ff_mutex_lock(&mutex);
+    char line[LINE_SZ];
 
-    format_line(ptr, level, fmt, vl, part, &print_prefix, type);
-    snprintf(line, sizeof(line), "%s%s%s%s", part[0].str, part[1].str, part[2].str, part[3].str);
+    snprintf(line, sizeof(line), "%s%s%s%s", part[0], part[1], part[2], part[3]);
 
 #if HAVE_ISATTY
     if (!is_atty)
@@ -327,31 +317,424 @@ void av_log_default_callback(void* ptr, int level, const char* fmt, va_list vl)
 
     if (print_prefix && (flags & AV_LOG_SKIP_REPEATED) && !strcmp(line, prev) &&
         *line && line[strlen(line) - 1] != '\r'){
-        count++;
+        count += n;
         if (is_atty == 1)
             fprintf(stderr, "    Last message repeated %d times\r", count);
-        goto end;
+        return;
     }
     if (count > 0) {
         fprintf(stderr, "    Last message repeated %d times\n", count);
         count = 0;
     }
     strcpy(prev, line);
-    sanitize(part[0].str);
-    colored_fputs(type[0], 0, part[0].str);
-    sanitize(part[1].str);
-    colored_fputs(type[1], 0, part[1].str);
-    sanitize(part[2].str);
-    colored_fputs(av_clip(level >> 3, 0, NB_LEVELS - 1), tint >> 8, part[2].str);
-    sanitize(part[3].str);
-    colored_fputs(av_clip(level >> 3, 0, NB_LEVELS - 1), tint >> 8, part[3].str);
+    sanitize(part[0]);
+    colored_fputs(type[0], 0, part[0]);
+    sanitize(part[1]);
+    colored_fputs(type[1], 0, part[1]);
+    sanitize(part[2]);
+    colored_fputs(av_clip(level >> 3, 0, NB_LEVELS - 1), tint >> 8, part[2]);
+    sanitize(part[3]);
+    colored_fputs(av_clip(level >> 3, 0, NB_LEVELS - 1), tint >> 8, part[3]);
+    count = n - 1;
 
 #if CONFIG_VALGRIND_BACKTRACE
     if (level <= BACKTRACE_LOGLEVEL)
         VALGRIND_PRINTF_BACKTRACE("%s", "");
 #endif
+}
+
+#if HAVE_PTHREADS
+/*
+ * Asynchronous mode: every thread formats its messages into its own ring
+ * without taking any lock and a background thread prints them in the order
+ * they were logged. Messages only take the space they need, so a ring holds
+ * a few hundred typical lines; when it is full, messages are dropped and
+ * counted instead of blocking the logging thread.
+ */
+#define RING_SIZE (1 << 16)
+
+typedef struct LogMessage {
+    int len;                ///< bytes taken in the ring
+    int size;               ///< bytes used in text, -1 for the padding at the end of the ring
+    unsigned seq;
+    int level;
+    unsigned tint;
+    int print_prefix;
+    int type[2];
+    int repeat;             ///< number of times the message was logged
+    int dropped;            ///< messages of the thread dropped before this one
+    char text[LINE_SZ + 3]; ///< the 4 parts, each followed by a 0
+} LogMessage;
+
+#define MESSAGE_LEN(m) FFALIGN(offsetof(LogMessage, text) + (m)->size, 8)
+
+typedef struct LogRing {
+    uint8_t buf[RING_SIZE];
+    atomic_uint head;
+    atomic_uint tail;
+    atomic_int in_use;      ///< cleared when the owning thread exits
+
+    /* only accessed by the owning thread while async logging is running */
+    int print_prefix;
+    int repeat;             ///< repetitions of last not queued yet
+    int dropped;
+    char prev[LINE_SZ];
+    LogMessage last;        ///< last message queued
+} LogRing;
+
+static pthread_key_t ring_key;
+
+static AVMutex ring_lock = AV_MUTEX_INITIALIZER;
+static LogRing **rings;
+static int nb_rings;
+
+static AVMutex async_ctl = AV_MUTEX_INITIALIZER;
+static pthread_mutex_t async_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t async_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t async_thread;
+static int async_stop;
+
+static atomic_int async_running = ATOMIC_VAR_INIT(0);
+static atomic_int async_users   = ATOMIC_VAR_INIT(0);
+static atomic_int async_pending = ATOMIC_VAR_INIT(0);
+static atomic_uint log_seq      = ATOMIC_VAR_INIT(0);
+
+/* The rings and the key are only touched between enter_rings() and
+ * leave_rings(), so that log_async_stop() can free them once no thread is
+ * using them. */
+static int enter_rings(void)
+{
+    atomic_fetch_add(&async_users, 1);
+    if (atomic_load(&async_running))
+        return 1;
+    atomic_fetch_sub(&async_users, 1);
+    return 0;
+}
+
+static void leave_rings(void)
+{
+    atomic_fetch_sub(&async_users, 1);
+}
+
+static void ring_release(void *opaque)
+{
+    LogRing *ring = opaque;
+
+    if (!enter_rings())
+        return;
+    atomic_store(&ring->in_use, 0);
+    leave_rings();
+}
+
+static LogRing *get_ring(void)
+{
+    LogRing *ring = pthread_getspecific(ring_key);
+
+    if (ring)
+        return ring;
+
+    ring = av_mallocz(sizeof(*ring));
+    if (!ring)
+        return NULL;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->in_use, 1);
+    ring->print_prefix = 1;
+
+    ff_mutex_lock(&ring_lock);
+    if (av_dynarray_add_nofree(&rings, &nb_rings, ring) < 0) {
+        av_freep(&ring);
+    } else if (pthread_setspecific(ring_key, ring)) {
+        nb_rings--;
+        av_freep(&ring);
+    }
+    ff_mutex_unlock(&ring_lock);
+
+    return ring;
+}
+
+static void push_message(LogRing *ring, const LogMessage *m, int n)
+{
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    unsigned used = head - atomic_load_explicit(&ring->tail, memory_order_acquire);
+    unsigned pos  = head % RING_SIZE, len = MESSAGE_LEN(m), pad = 0;
+    LogMessage *slot;
+
+    /* messages are never split, skip the end of the ring if needed */
+    if (pos + len > RING_SIZE)
+        pad = RING_SIZE - pos;
+    if (RING_SIZE - used < pad + len) {
+        ring->dropped += n;
+        return;
+    }
+    if (pad) {
+        slot = (LogMessage *)(ring->buf + pos);
+        slot->len  = pad;
+        slot->size = -1;
+        head += pad;
+        pos   = 0;
+    }
+
+    slot = (LogMessage *)(ring->buf + pos);
+    memcpy(slot, m, offsetof(LogMessage, text) + m->size);
+    slot->len     = len;
+    slot->repeat  = n;
+    slot->dropped = ring->dropped;
+    slot->seq     = atomic_fetch_add(&log_seq, 1);
+    ring->dropped = 0;
+    atomic_store_explicit(&ring->head, head + len, memory_order_release);
+
+    if (!atomic_exchange(&async_pending, 1)) {
+        pthread_mutex_lock(&async_lock);
+        pthread_cond_signal(&async_cond);
+        pthread_mutex_unlock(&async_lock);
+    }
+}
+
+static void queue_message(LogRing *ring, void *ptr, int level, unsigned tint,
+                          const char *fmt, va_list vl)
+{
+    LogMessage *m = &ring->last;
+    AVBPrint part[4];
+    char line[LINE_SZ];
+    int type[2];
+    int i, len, left = LINE_SZ - 1;
+
+    format_line(ptr, level, fmt, vl, part, &ring->print_prefix, type);
+    snprintf(line, sizeof(line), "%s%s%s%s", part[0].str, part[1].str, part[2].str, part[3].str);
+
+    /* identical lines are only counted, so a flood of the same warning
+     * costs little more than formatting it */
+    if (ring->print_prefix && (flags & AV_LOG_SKIP_REPEATED) && !strcmp(line, ring->prev) &&
+        *line && line[strlen(line) - 1] != '\r') {
+        ring->repeat++;
+        goto end;
+    }
+    if (ring->repeat) {
+        push_message(ring, m, ring->repeat);
+        ring->repeat = 0;
+    }
+
+    m->level        = level;
+    m->tint         = tint;
+    m->print_prefix = ring->print_prefix;
+    m->type[0]      = type[0];
+    m->type[1]      = type[1];
+    m->size         = 0;
+    for (i = 0; i < 4; i++) {
+        len = FFMIN(strlen(part[i].str), left);
+        memcpy(m->text + m->size, part[i].str, len);
+        m->text[m->size + len] = 0;
+        m->size += len + 1;
+        left    -= len;
+    }
+    push_message(ring, m, 1);
+    strcpy(ring->prev, line);
 end:
     av_bprint_finalize(part+3, NULL);
+}
+
+static void print_message(LogMessage *m)
+{
+    char *part[4];
+    int i;
+
+    if (m->dropped)
+        fprintf(stderr, "    %d log messages dropped\n", m->dropped);
+    if (!m->repeat)
+        return;
+
+    part[0] = m->text;
+    for (i = 1; i < 4; i++)
+        part[i] = part[i - 1] + strlen(part[i - 1]) + 1;
+    log_output(m->level, m->tint, m->print_prefix, m->type, part, m->repeat);
+}
+
+static LogMessage *first_message(LogRing *ring)
+{
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    LogMessage *m;
+
+    if (tail == head)
+        return NULL;
+    m = (LogMessage *)(ring->buf + tail % RING_SIZE);
+    if (m->size < 0) {
+        tail += m->len;
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+        if (tail == head)
+            return NULL;
+        m = (LogMessage *)ring->buf;
+    }
+    return m;
+}
+
+/* Print the repetitions and drops of the thread not queued yet. */
+static void print_pending(LogRing *ring)
+{
+    ring->last.repeat  = ring->repeat;
+    ring->last.dropped = ring->dropped;
+    print_message(&ring->last);
+    ring->repeat  = 0;
+    ring->dropped = 0;
+}
+
+/* Print all queued messages, ordered by their sequence number. */
+static void flush_rings(void)
+{
+    int i;
+
+    ff_mutex_lock(&ring_lock);
+    ff_mutex_lock(&mutex);
+    for (;;) {
+        LogRing *next = NULL;
+        LogMessage *m = NULL, *first;
+
+        for (i = 0; i < nb_rings; i++) {
+            first = first_message(rings[i]);
+            if (first && (!m || (int)(first->seq - m->seq) < 0)) {
+                next = rings[i];
+                m    = first;
+            }
+        }
+        if (!next)
+            break;
+
+        print_message(m);
+        atomic_fetch_add_explicit(&next->tail, m->len, memory_order_release);
+    }
+
+    /* the rings of exited threads are drained now */
+    for (i = 0; i < nb_rings; i++) {
+        if (!atomic_load(&rings[i]->in_use)) {
+            print_pending(rings[i]);
+            av_freep(&rings[i]);
+            rings[i--] = rings[--nb_rings];
+        }
+    }
+    ff_mutex_unlock(&mutex);
+    ff_mutex_unlock(&ring_lock);
+}
+
+static void *log_thread(void *arg)
+{
+    pthread_mutex_lock(&async_lock);
+    while (!async_stop) {
+        while (!atomic_load(&async_pending) && !async_stop)
+            pthread_cond_wait(&async_cond, &async_lock);
+        pthread_mutex_unlock(&async_lock);
+
+        atomic_store(&async_pending, 0);
+        flush_rings();
+
+        pthread_mutex_lock(&async_lock);
+    }
+    pthread_mutex_unlock(&async_lock);
+    return NULL;
+}
+
+/* Return 0 if the message was queued. */
+static int log_async(void *ptr, int level, unsigned tint, const char *fmt, va_list vl)
+{
+    LogRing *ring;
+    int ret = -1;
+
+    if (!enter_rings())
+        return -1;
+    if ((ring = get_ring())) {
+        queue_message(ring, ptr, level, tint, fmt, vl);
+        ret = 0;
+    }
+    leave_rings();
+    return ret;
+}
+
+static int log_async_start(void)
+{
+    int ret;
+
+    if ((ret = pthread_key_create(&ring_key, ring_release)))
+        return AVERROR(ret);
+
+    async_stop = 0;
+    atomic_store(&async_pending, 0);
+    if ((ret = pthread_create(&async_thread, NULL, log_thread, NULL))) {
+        pthread_key_delete(ring_key);
+        return AVERROR(ret);
+    }
+    atomic_store(&async_running, 1);
+    return 0;
+}
+
+static void log_async_stop(void)
+{
+    int i;
+
+    /* wait for the threads in the middle of queuing a message or exiting,
+     * anything logged from now on is printed directly */
+    atomic_store(&async_running, 0);
+    while (atomic_load(&async_users))
+        av_usleep(100);
+
+    pthread_mutex_lock(&async_lock);
+    async_stop = 1;
+    pthread_cond_signal(&async_cond);
+    pthread_mutex_unlock(&async_lock);
+    pthread_join(async_thread, NULL);
+
+    flush_rings();
+
+    /* no thread uses its ring anymore, release them all */
+    ff_mutex_lock(&ring_lock);
+    ff_mutex_lock(&mutex);
+    pthread_key_delete(ring_key);
+    for (i = 0; i < nb_rings; i++) {
+        print_pending(rings[i]);
+        av_freep(&rings[i]);
+    }
+    av_freep(&rings);
+    nb_rings = 0;
+    ff_mutex_unlock(&mutex);
+    ff_mutex_unlock(&ring_lock);
+}
+#endif /* HAVE_PTHREADS */
+
+void av_log_default_callback(void* ptr, int level, const char* fmt, va_list vl)
+{
+    static int print_prefix = 1;
+    AVBPrint part[4];
+    char *str[4];
+    int type[2];
+    unsigned tint = 0;
+
+    if (level >= 0) {
+        tint = level & 0xff00;
+        level &= 0xff;
+    }
+
+    if (level > av_log_level)
+        return;
+
+#if HAVE_PTHREADS
+    if (atomic_load_explicit(&async_running, memory_order_relaxed)) {
+        /* fatal messages are usually followed by an exit or an abort, so
+         * print them right away, after everything queued before them */
+        if (level > AV_LOG_FATAL && !log_async(ptr, level, tint, fmt, vl))
+            return;
+        flush_rings();
+    }
+#endif
+
+    ff_mutex_lock(&mutex);
+
+    format_line(ptr, level, fmt, vl, part, &print_prefix, type);
+    str[0] = part[0].str;
+    str[1] = part[1].str;
+    str[2] = part[2].str;
+    str[3] = part[3].str;
+    log_output(level, tint, print_prefix, type, str, 1);
+
+    av_bprint_finalize(part+3, NULL);
     ff_mutex_unlock(&mutex);
 }
 
@@ -389,7 +772,19 @@ void av_log_set_level(int level)
 
 void av_log_set_flags(int arg)
 {
+#if HAVE_PTHREADS
+    ff_mutex_lock(&async_ctl);
+    if ((arg & AV_LOG_ASYNC) && !atomic_load(&async_running)) {
+        if (log_async_start() < 0)
+            arg &= ~AV_LOG_ASYNC;
+    } else if (!(arg & AV_LOG_ASYNC) && atomic_load(&async_running)) {
+        log_async_stop();
+    }
     flags = arg;
+    ff_mutex_unlock(&async_ctl);
+#else
+    flags = arg & ~AV_LOG_ASYNC;
+#endif
 }
 
 int av_log_get_flags(void)
@@ -352,6 +352,23 @@ int av_log_format_line2(void *ptr, int level, const char *fmt, va_list vl,
  */
 #define AV_LOG_PRINT_LEVEL 2
 
+/**
+ * Let a background thread print the messages of the default callback.
+ *
+ * Each thread formats its messages into its own queue without waiting for
+ * the output or for other threads; messages that do not fit into a full
+ * queue are dropped and counted. With AV_LOG_SKIP_REPEATED, repeated lines
+ * are counted by the logging thread without being queued. Messages at
+ * AV_LOG_FATAL and below are printed synchronously, after everything queued
+ * before them, and lines are truncated to 1023 bytes.
+ *
+ * The background thread is started when this flag is set and stopped, after
+ * printing all pending messages, when it is cleared again, which should be
+ * done before exiting. The flag is ignored if lavu was built without
+ * pthreads support or the thread could not be started.
+ */
+#define AV_LOG_ASYNC 4
+
 void av_log_set_flags(int arg);
 int av_log_get_flags(void);
 
@@ -0,0 +1,121 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+
+static void print_usage(AVBufferAccount *account, const char *what)
+{
+    int64_t peak, usage = av_buffer_account_get_usage(account, &peak);
+
+    printf("%-32s usage %6"PRId64", peak %6"PRId64"\n", what, usage, peak);
+}
+
+int main(void)
+{
+    AVBufferAccount *account = av_buffer_account_alloc(), *prev;
+    AVBufferRef *a, *b, *c, *ref;
+    AVBufferPool *pool;
+    AVFrame *frame;
+    int ret;
+
+    if (!account)
+        return 1;
+
+    printf("Testing the limit\n");
+    av_buffer_account_set_limit(account, 1000);
+    prev = av_buffer_account_enter(account);
+    a = av_buffer_alloc(600);
+    print_usage(account, "alloc 600");
+    b = av_buffer_alloc(600);
+    printf("alloc 600 over the limit: %s\n", b ? "allocated" : "failed");
+    print_usage(account, "after the failed alloc");
+    if (!a)
+        return 1;
+
+    printf("Testing av_buffer_realloc()\n");
+    c = NULL;
+    ret = av_buffer_realloc(&c, 300);
+    print_usage(account, "realloc NULL to 300");
+    if (ret < 0)
+        return 1;
+    ret = av_buffer_realloc(&c, 500);
+    printf("realloc to 500: %s, size %d\n", ret < 0 ? "failed" : "ok", c->size);
+    print_usage(account, "after the failed realloc");
+    ret = av_buffer_realloc(&c, 350);
+    printf("realloc to 350: %s, size %d\n", ret < 0 ? "failed" : "ok", c->size);
+    print_usage(account, "realloc 350");
+    b = av_buffer_allocz(50);
+    print_usage(account, "allocz 50 up to the limit");
+    if (!b)
+        return 1;
+
+    printf("Testing unref\n");
+    ref = av_buffer_ref(a);
+    av_buffer_unref(&a);
+    print_usage(account, "unref with a reference left");
+    av_buffer_unref(&ref);
+    print_usage(account, "unref the last reference");
+    av_buffer_unref(&c);
+    print_usage(account, "unref the reallocated buffer");
+
+    printf("Testing pools\n");
+    pool = av_buffer_pool_init(256, NULL);
+    if (!pool)
+        return 1;
+    a = av_buffer_pool_get(pool);
+    print_usage(account, "pool get");
+    av_buffer_unref(&a);
+    print_usage(account, "returned to the pool");
+    a = av_buffer_pool_get(pool);
+    print_usage(account, "pool get again");
+    av_buffer_pool_uninit(&pool);
+    print_usage(account, "pool uninit with a buffer out");
+    av_buffer_unref(&a);
+    print_usage(account, "last buffer returned");
+
+    printf("Testing side data\n");
+    frame = av_frame_alloc();
+    if (!frame)
+        return 1;
+    if (!av_frame_new_side_data(frame, AV_FRAME_DATA_A53_CC, 100))
+        return 1;
+    print_usage(account, "side data 100");
+    av_buffer_account_set_limit(account, 200);
+    printf("side data over the limit: %s\n",
+           av_frame_new_side_data(frame, AV_FRAME_DATA_A53_CC, 100) ? "allocated" : "failed");
+    av_buffer_account_set_limit(account, 0);
+    av_frame_free(&frame);
+    print_usage(account, "frame freed");
+
+    printf("Testing leave and free\n");
+    av_buffer_account_leave(prev);
+    a = av_buffer_alloc(1000);
+    print_usage(account, "alloc after leave");
+    av_buffer_unref(&a);
+
+    /* the account outlives its buffers */
+    av_buffer_account_free(&account);
+    av_buffer_unref(&b);
+    printf("account freed before its last buffer\n");
+
+    return 0;
+}
@@ -49,6 +49,60 @@ static void test_separators(const AVDictionary *m, const char pair, const char v
     av_dict_free(&dict);
 }
 
+static const AVDictionaryEntry *linear_get(const AVDictionary *m, const char *key, int flags)
+{
+    int i;
+    for (i = 0; i < av_dict_count(m); i++)
+        if (flags & AV_DICT_MATCH_CASE ? !strcmp(m->elems[i].key, key)
+                                       : !av_strcasecmp(m->elems[i].key, key))
+            return &m->elems[i];
+    return NULL;
+}
+
+static void test_hash(void)
+{
+    AVDictionary *dict = NULL;
+    char key[16];
+    int i, j, errors = 0;
+
+    for (i = 0; i < 300; i++) {
+        snprintf(key, sizeof(key), i & 1 ? "Key%d" : "key%d", i % 200);
+        av_dict_set_int(&dict, key, i, i % 7 ? 0 : AV_DICT_MULTIKEY);
+        if (i % 5 == 0) {
+            snprintf(key, sizeof(key), "KEY%d", i / 3);
+            av_dict_set(&dict, key, NULL, 0);
+        }
+        for (j = 0; j < 210; j++) {
+            snprintf(key, sizeof(key), j & 2 ? "kEy%d" : "key%d", j);
+            if (av_dict_get(dict, key, NULL, 0) != linear_get(dict, key, 0) ||
+                av_dict_get(dict, key, NULL, AV_DICT_MATCH_CASE) !=
+                linear_get(dict, key, AV_DICT_MATCH_CASE))
+                errors++;
+        }
+    }
+    printf("%d entries, %d mismatches\n", av_dict_count(dict), errors);
+
+    /* shrink below the size at which the index is built, it must keep
+     * tracking the entries set afterwards */
+    while (av_dict_count(dict) > 10) {
+        AVDictionaryEntry *e = av_dict_get(dict, "", NULL, AV_DICT_IGNORE_SUFFIX);
+        av_strlcpy(key, e->key, sizeof(key));
+        av_dict_set(&dict, key, NULL, 0);
+    }
+    for (i = 0; i < 20; i++) {
+        snprintf(key, sizeof(key), "new%d", i % 10);
+        av_dict_set_int(&dict, key, i, 0);
+        for (j = 0; j < 10; j++) {
+            snprintf(key, sizeof(key), "NEW%d", j);
+            if (av_dict_get(dict, key, NULL, 0) != linear_get(dict, key, 0) ||
+                (j <= i && !av_dict_get(dict, key, NULL, 0)))
+                errors++;
+        }
+    }
+    printf("%d entries, %d mismatches\n", av_dict_count(dict), errors);
+    av_dict_free(&dict);
+}
+
 int main(void)
 {
     AVDictionary *dict = NULL;
@@ -132,5 +186,8 @@ int main(void)
     printf("%s\n", e->value);
     av_dict_free(&dict);
 
+    printf("\nTesting av_dict_get() on a large dictionary\n");
+    test_hash();
+
     return 0;
 }
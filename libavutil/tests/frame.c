@@ -0,0 +1,118 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/frame.c"
+
+static void print_pools(void)
+{
+    int i;
+
+    printf("pools:");
+    for (i = 0; i < SIDE_DATA_POOLS; i++)
+        if (atomic_load(&side_data_pools[i]))
+            printf(" %d", 64 << i);
+    printf("\n");
+}
+
+static AVFrameSideData *new_side_data(AVFrame *frame, int size, int val)
+{
+    AVFrameSideData *sd = av_frame_new_side_data(frame, AV_FRAME_DATA_A53_CC, size);
+
+    if (sd)
+        memset(sd->data, val, size);
+    return sd;
+}
+
+static void print_side_data(const AVFrame *src, const AVFrame *dst,
+                            const int *sizes)
+{
+    int i;
+
+    for (i = 0; i < dst->nb_side_data; i++) {
+        const AVFrameSideData *sd_src = src->side_data[i];
+        const AVFrameSideData *sd_dst = dst->side_data[i];
+        printf("%d: %s, size %d, %s\n", sizes[i],
+               sd_dst->data == sd_src->data ? "shared" : "copied", sd_dst->size,
+               av_buffer_is_writable(sd_dst->buf) ? "writable" : "not writable");
+    }
+}
+
+int main(void)
+{
+    static const int sizes[] = { 0, 1, 64, 65, 4096, 32768, 32769 };
+    AVFrame *src = av_frame_alloc(), *dst = av_frame_alloc();
+    AVFrame tmp = { 0 };
+    AVFrameSideData *sd_src, *sd_dst;
+    AVBufferRef *ref;
+    int i;
+
+    if (!src || !dst)
+        return 1;
+
+    printf("Testing side data sizes\n");
+    for (i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+        sd_src = new_side_data(src, sizes[i], i);
+        if (!sd_src)
+            return 1;
+        printf("%d: size %d, buffer size %d\n", sizes[i], sd_src->size,
+               sd_src->buf->size);
+    }
+    print_pools();
+
+    printf("Testing av_frame_copy_props()\n");
+    if (av_frame_copy_props(dst, src) < 0)
+        return 1;
+    print_side_data(src, dst, sizes);
+    av_frame_unref(dst);
+
+    printf("Testing av_frame_copy_props_shared()\n");
+    if (av_frame_copy_props_shared(dst, src) < 0)
+        return 1;
+    print_side_data(src, dst, sizes);
+
+    /* modifying shared side data takes a copy first */
+    sd_dst = dst->side_data[4];
+    if (av_buffer_make_writable(&sd_dst->buf) < 0)
+        return 1;
+    sd_dst->data = sd_dst->buf->data;
+    memset(sd_dst->data, 0xff, sd_dst->size);
+    printf("after make writable: src %d, dst %d\n",
+           src->side_data[4]->data[0], sd_dst->data[0]);
+
+    printf("Testing the pool lifetime\n");
+    ref = av_buffer_ref(src->side_data[2]->buf);
+    if (!ref)
+        return 1;
+    av_frame_free(&src);
+    av_frame_free(&dst);
+    print_pools();
+    av_frame_side_data_pools_uninit();
+    print_pools();
+
+    /* after the pools are freed, side data is allocated directly */
+    if (!new_side_data(&tmp, 64, 0))
+        return 1;
+    print_pools();
+    av_frame_unref(&tmp);
+
+    /* the buffer still referenced is freed along with its pool */
+    printf("outstanding buffer: %d\n", ref->data[0]);
+    av_buffer_unref(&ref);
+
+    return 0;
+}
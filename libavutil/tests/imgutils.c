@@ -20,9 +20,128 @@
 
 #undef printf
 
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+
+/* runs the jobs backwards, so slices depending on each other would show */
+static void execute_reverse(void *opaque, av_image_job_func *func, void *arg,
+                            int nb_jobs)
+{
+    int i;
+
+    for (i = nb_jobs - 1; i >= 0; i--)
+        func(arg, i, nb_jobs);
+}
+
+/* Lines are padded to 64 bytes, or by pad bytes with the data starting off
+ * by one byte, so that neither the lines nor the data are aligned. */
+static int alloc_image(uint8_t *data[4], int linesize[4], uint8_t **buf,
+                       enum AVPixelFormat pix_fmt, int w, int h, int pad)
+{
+    int i, size;
+
+    if (av_image_fill_linesizes(linesize, pix_fmt, w) < 0)
+        return -1;
+    for (i = 0; i < 4; i++)
+        if (linesize[i])
+            linesize[i] = pad ? linesize[i] + pad : FFALIGN(linesize[i], 64);
+    if ((size = av_image_fill_pointers(data, pix_fmt, h, NULL, linesize)) < 0 ||
+        !(*buf = av_malloc(size + 1)))
+        return -1;
+    av_image_fill_pointers(data, pix_fmt, h, *buf + !!pad, linesize);
+    return size + 1;
+}
+
+/* reference copy, one memcpy() per line */
+static void copy_lines(uint8_t *dst_data[4], const int dst_linesize[4],
+                       uint8_t *src_data[4], const int src_linesize[4],
+                       enum AVPixelFormat pix_fmt, int w, int h)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
+    int i, y;
+
+    for (i = 0; i < 4 && dst_data[i]; i++) {
+        int bytewidth = av_image_get_linesize(pix_fmt, w, i);
+        int lines = (i == 1 || i == 2) ? AV_CEIL_RSHIFT(h, desc->log2_chroma_h) : h;
+
+        if (i == 1 && (desc->flags & AV_PIX_FMT_FLAG_PAL || desc->flags & FF_PSEUDOPAL)) {
+            memcpy(dst_data[1], src_data[1], 4 * 256);
+            continue;
+        }
+        for (y = 0; y < lines; y++)
+            memcpy(dst_data[i] + y * dst_linesize[i],
+                   src_data[i] + y * src_linesize[i], bytewidth);
+    }
+}
+
+static int check_copy(enum AVPixelFormat pix_fmt, int w, int h, int nb_jobs,
+                      int src_pad, int dst_pad)
+{
+    uint8_t *src_data[4], *ref_data[4], *dst_data[4];
+    uint8_t *src_buf = NULL, *ref_buf = NULL, *dst_buf = NULL;
+    int src_linesize[4], ref_linesize[4], dst_linesize[4];
+    ptrdiff_t src_linesize1[4], dst_linesize1[4];
+    int i, size, ret = -1;
+    AVLFG lfg;
+
+    if ((size = alloc_image(src_data, src_linesize, &src_buf, pix_fmt, w, h, src_pad)) < 0)
+        goto end;
+    av_lfg_init(&lfg, 1);
+    for (i = 0; i < size; i++)
+        src_buf[i] = av_lfg_get(&lfg);
+
+    /* the padding has to be left alone */
+    if ((size = alloc_image(ref_data, ref_linesize, &ref_buf, pix_fmt, w, h, dst_pad)) < 0 ||
+        alloc_image(dst_data, dst_linesize, &dst_buf, pix_fmt, w, h, dst_pad) < 0)
+        goto end;
+    memset(ref_buf, 0xAA, size);
+    memset(dst_buf, 0xAA, size);
+
+    for (i = 0; i < 4; i++) {
+        src_linesize1[i] = src_linesize[i];
+        dst_linesize1[i] = dst_linesize[i];
+    }
+    copy_lines(ref_data, ref_linesize, src_data, src_linesize, pix_fmt, w, h);
+    av_image_copy_execute(dst_data, dst_linesize1, (const uint8_t **)src_data,
+                          src_linesize1, pix_fmt, w, h, execute_reverse, NULL, nb_jobs);
+
+    ret = memcmp(ref_buf, dst_buf, size) ? -1 : 0;
+    printf("%s %dx%d, %d jobs", av_get_pix_fmt_name(pix_fmt), w, h, nb_jobs);
+    if (src_pad || dst_pad)
+        printf(", unaligned linesizes %d/%d", src_linesize[0], dst_linesize[0]);
+    printf(": %s\n", ret ? "mismatch" : "ok");
+
+end:
+    av_freep(&src_buf);
+    av_freep(&ref_buf);
+    av_freep(&dst_buf);
+    return ret;
+}
+
 int main(void)
 {
+    static const struct {
+        enum AVPixelFormat pix_fmt;
+        int w, h, nb_jobs, src_pad, dst_pad;
+    } copies[] = {
+        { AV_PIX_FMT_YUV420P,     67,   37, 4 },
+        { AV_PIX_FMT_YUV420P,     67,   37, 1 },
+        { AV_PIX_FMT_YUV422P10LE, 33,   65, 7 },
+        { AV_PIX_FMT_YUV410P,     35,   17, 3 },
+        { AV_PIX_FMT_NV12,        64,   33, 5 },
+        { AV_PIX_FMT_YUVA420P,    31,   31, 2 },
+        { AV_PIX_FMT_RGB24,       17,    9, 16 },
+        { AV_PIX_FMT_PAL8,        32,   32, 4 },
+        { AV_PIX_FMT_RGBA,      1100, 1000, 8 },
+        /* large enough for non-temporal stores, the width is not a multiple
+         * of their block size */
+        { AV_PIX_FMT_GRAY8,     2085, 2049, 1 },
+        { AV_PIX_FMT_GRAY16LE,  2085, 1025, 6, 3, 0 },
+        { AV_PIX_FMT_YUV420P,   2085, 2049, 4, 0, 5 },
+        { AV_PIX_FMT_RGB24,     1399, 1001, 3, 7, 9 },
+    };
     int64_t x, y;
+    int i, ret = 0;
 
     for (y = -1; y<UINT_MAX; y+= y/2 + 1) {
         for (x = -1; x<UINT_MAX; x+= x/2 + 1) {
@@ -32,5 +151,9 @@ int main(void)
         printf("\n");
     }
 
-    return 0;
+    for (i = 0; i < FF_ARRAY_ELEMS(copies); i++)
+        ret |= check_copy(copies[i].pix_fmt, copies[i].w, copies[i].h,
+                          copies[i].nb_jobs, copies[i].src_pad, copies[i].dst_pad);
+
+    return !!ret;
 }
@@ -23,6 +23,135 @@
 
 #include <string.h>
 
+#if HAVE_PTHREADS
+#include <unistd.h>
+
+#define NB_THREADS 4
+#define NB_LINES   1000
+#define NB_DROP    2000
+
+static void *log_thread_test(void *arg)
+{
+    int i;
+
+    for (i = 0; i < NB_LINES; i++) {
+        if (i % 100 < 50)
+            av_log(NULL, AV_LOG_INFO, "thread %d: repeated line\n", (int)(intptr_t)arg);
+        else
+            av_log(NULL, AV_LOG_INFO, "thread %d: line %d\n", (int)(intptr_t)arg, i);
+    }
+    return NULL;
+}
+
+/* Check the output captured from the async callback: every line of a
+ * thread appears in order, repetitions add up and nothing is lost. */
+static int check_async_output(FILE *f)
+{
+    int repeated[NB_THREADS] = { 0 }, next[NB_THREADS] = { 0 };
+    int lines = 0, reordered = 0, dropped = 0, drop_lines = 0, last_drop = -1;
+    int before = 0, after = 0, last = -1;
+    char buf[1024];
+    int i, t, n;
+
+    while (fgets(buf, sizeof(buf), f)) {
+        /* on a terminal, the repetitions are also printed as they come */
+        char *line = strrchr(buf, '\r') ? strrchr(buf, '\r') + 1 : buf;
+
+        if (sscanf(line, "    Last message repeated %d times", &n) == 1) {
+            if (last >= 0)
+                repeated[last] += n;
+            else
+                reordered++;
+            continue;
+        }
+        last = -1;
+        if (sscanf(line, "    %d log messages dropped", &n) == 1) {
+            dropped += n;
+        } else if (sscanf(line, "thread %d: line %d", &t, &n) == 2 &&
+                   t >= 0 && t < NB_THREADS) {
+            /* the unique lines are the second half of every 100 */
+            if (next[t] % 100 < 50)
+                next[t] += 50;
+            if (n != next[t] || !before || after)
+                reordered++;
+            next[t] = n + 1;
+            lines++;
+        } else if (sscanf(line, "thread %d: repeated line", &t) == 1 &&
+                   t >= 0 && t < NB_THREADS) {
+            if (!before || after)
+                reordered++;
+            repeated[t]++;
+            last = t;
+        } else if (sscanf(line, "drop %d", &n) == 1) {
+            if (n <= last_drop)
+                reordered++;
+            last_drop = n;
+            drop_lines++;
+        } else if (!strcmp(line, "before\n")) {
+            before++;
+        } else if (!strcmp(line, "after\n")) {
+            after++;
+        }
+    }
+
+    for (i = 0; i < NB_THREADS; i++) {
+        printf("thread %d: %d repeated lines\n", i, repeated[i]);
+        if (repeated[i] != NB_LINES / 2)
+            reordered++;
+    }
+    printf("%d lines, %d out of order\n", lines, reordered);
+    printf("drop: %d lines printed or counted as dropped, %s dropped\n",
+           drop_lines + dropped, dropped ? "some" : "none");
+    return lines != NB_THREADS * NB_LINES / 2 || reordered ||
+           before != 1 || after != 1 || drop_lines + dropped != NB_DROP || !dropped;
+}
+
+static int test_async(void)
+{
+    pthread_t threads[NB_THREADS];
+    FILE *out = tmpfile();
+    int saved_stderr, i, ret;
+
+    if (!out || (saved_stderr = dup(2)) < 0) {
+        printf("Test async logging failed to capture stderr.\n");
+        return 1;
+    }
+    fflush(stderr);
+    dup2(fileno(out), 2);
+    use_color = 0;
+
+    av_log_set_flags(AV_LOG_SKIP_REPEATED | AV_LOG_ASYNC);
+    if (!(av_log_get_flags() & AV_LOG_ASYNC)) {
+        dup2(saved_stderr, 2);
+        printf("Test async logging failed to start.\n");
+        return 1;
+    }
+    av_log(NULL, AV_LOG_INFO, "before\n");
+    for (i = 0; i < NB_THREADS; i++)
+        pthread_create(&threads[i], NULL, log_thread_test, (void *)(intptr_t)i);
+    for (i = 0; i < NB_THREADS; i++)
+        pthread_join(threads[i], NULL);
+    av_log(NULL, AV_LOG_INFO, "after\n");
+
+    /* the logging thread cannot print while the log mutex is held, so the
+     * ring of this thread fills up and the rest is dropped */
+    ff_mutex_lock(&mutex);
+    for (i = 0; i < NB_DROP; i++)
+        av_log(NULL, AV_LOG_INFO, "drop %d\n", i);
+    ff_mutex_unlock(&mutex);
+    av_log_set_flags(0);
+
+    fflush(stderr);
+    dup2(saved_stderr, 2);
+    close(saved_stderr);
+
+    rewind(out);
+    ret = check_async_output(out);
+    fclose(out);
+    return ret;
+}
+#endif
+
 static int call_log_format_line2(const char *fmt, char *buffer, int buffer_size, ...)
 {
     va_list args;
@@ -67,5 +196,9 @@ int main(int argc, char **argv)
             return 1;
         }
     }
+#if HAVE_PTHREADS
+    if (test_async())
+        return 1;
+#endif
     return 0;
 }
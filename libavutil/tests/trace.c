@@ -0,0 +1,169 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/bprint.h"
+#include "libavutil/common.h"
+#include "libavutil/trace.h"
+
+/* print the phase, thread and name of each event, and check that every
+ * begin is matched by an end on the same thread */
+static void flush_events(void)
+{
+    AVBPrint bp;
+    int depth[16] = { 0 };
+    const char *line;
+    int i, ret;
+
+    av_bprint_init(&bp, 0, AV_BPRINT_SIZE_UNLIMITED);
+    ret = av_trace_flush(&bp);
+    printf("%d events\n", ret);
+
+    for (line = bp.str; *line; line = strchr(line, '\n') + 1) {
+        const char *tid  = strstr(line, "\"tid\":");
+        const char *name = strstr(line, "\"name\":\"");
+        char ph = line[7];
+        int t = tid ? atoi(tid + 6) : 0;
+
+        if (t <= 0 || t >= FF_ARRAY_ELEMS(depth)) {
+            printf("bad event %.*s\n", (int)strcspn(line, "\n"), line);
+            continue;
+        }
+        if (ph == 'B') {
+            depth[t]++;
+            printf("tid %d B %.*s\n", t, name ? (int)strcspn(name + 8, "\"") : 0,
+                   name ? name + 8 : "");
+        } else {
+            if (!depth[t]--)
+                printf("tid %d unmatched end\n", t);
+            printf("tid %d E\n", t);
+        }
+    }
+    for (i = 0; i < FF_ARRAY_ELEMS(depth); i++)
+        if (depth[i] > 0)
+            printf("tid %d: %d spans not closed\n", i, depth[i]);
+
+    av_bprint_finalize(&bp, NULL);
+}
+
+static void *thread_spans(void *arg)
+{
+    av_trace_begin("test", "thread outer");
+    av_trace_begin("test", "thread inner");
+    av_trace_end();
+    av_trace_end();
+    return NULL;
+}
+
+static pthread_mutex_t step_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t step_cond   = PTHREAD_COND_INITIALIZER;
+static int step;
+
+static void set_step(int s)
+{
+    pthread_mutex_lock(&step_lock);
+    step = s;
+    pthread_cond_broadcast(&step_cond);
+    pthread_mutex_unlock(&step_lock);
+}
+
+static void wait_step(int s)
+{
+    pthread_mutex_lock(&step_lock);
+    while (step < s)
+        pthread_cond_wait(&step_cond, &step_lock);
+    pthread_mutex_unlock(&step_lock);
+}
+
+static void *thread_idle(void *arg)
+{
+    av_trace_begin("test", "before release");
+    av_trace_end();
+    set_step(1);
+    /* the buffer of this thread is released while it waits */
+    wait_step(2);
+    av_trace_begin("test", "after release");
+    av_trace_end();
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t thread;
+
+    if (av_trace_start() < 0)
+        return 1;
+
+    printf("Testing spans open across av_trace_stop()\n");
+    av_trace_begin("test", "a");
+    av_trace_begin("test", "b");
+    av_trace_stop();
+    av_trace_end();
+    av_trace_begin("test", "c");
+    av_trace_end();
+    av_trace_end();
+    av_trace_begin("test", "not recorded");
+    av_trace_end();
+    flush_events();
+
+    printf("Testing spans begun while stopped\n");
+    if (av_trace_start() < 0)
+        return 1;
+    av_trace_begin("test", "d");
+    av_trace_stop();
+    av_trace_begin("test", "e");
+    if (av_trace_start() < 0)
+        return 1;
+    av_trace_begin("test", "f");
+    av_trace_end();
+    av_trace_end();
+    av_trace_begin("test", "g");
+    av_trace_end();
+    av_trace_end();
+    flush_events();
+
+    printf("Testing spans from another thread\n");
+    if (pthread_create(&thread, NULL, thread_spans, NULL))
+        return 1;
+    pthread_join(thread, NULL);
+    av_trace_stop();
+    flush_events();
+    flush_events();
+
+    printf("Testing the buffer of an idle thread\n");
+    if (av_trace_start() < 0)
+        return 1;
+    if (pthread_create(&thread, NULL, thread_idle, NULL))
+        return 1;
+    wait_step(1);
+    av_trace_stop();
+    flush_events();
+    if (av_trace_start() < 0)
+        return 1;
+    set_step(2);
+    pthread_join(thread, NULL);
+    av_trace_stop();
+    flush_events();
+    flush_events();
+
+    return 0;
+}
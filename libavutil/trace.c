@@ -0,0 +1,345 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "bprint.h"
+#include "error.h"
+#include "mem.h"
+#include "thread.h"
+#include "time.h"
+#include "trace.h"
+
+/* per-thread keys are only available with real pthreads */
+#define TRACE_SUPPORTED (HAVE_PTHREADS || !HAVE_THREADS)
+
+#define RING_SIZE (1 << 14)
+
+typedef struct TraceEvent {
+    int64_t ts;
+    const char *category;
+    const char *name;       ///< NULL for the end of a span
+} TraceEvent;
+
+/**
+ * Single producer, single consumer ring: only the owning thread moves head
+ * and only av_trace_flush() moves tail.
+ */
+typedef struct TraceRing {
+    TraceEvent events[RING_SIZE];
+    atomic_uint head;
+    atomic_uint tail;
+    atomic_int state;       ///< RING_*, see below
+    int tid;
+
+    /* only written by the owning thread, av_trace_flush() reads them to
+     * find the rings it can release */
+    atomic_uint depth;      ///< recorded spans that are still open
+    atomic_uint skipped;    ///< dropped spans that are still open
+} TraceRing;
+
+/* An active ring is owned by its thread and listed in rings. When the
+ * thread exits, the ring is marked exited and av_trace_flush() frees it.
+ * When tracing is stopped, av_trace_flush() detaches the idle rings from
+ * the list; the owning thread then frees its ring the next time it looks
+ * at it, so that the hot path never has to synchronize with the flush. */
+enum {
+    RING_ACTIVE,
+    RING_EXITED,
+    RING_DETACHED,
+};
+
+enum {
+    TRACE_OFF,              ///< stopped, and no ring is listed
+    TRACE_STOPPED,          ///< stopped, but spans may still be open
+    TRACE_ON,
+};
+
+static atomic_int trace_state = ATOMIC_VAR_INIT(TRACE_OFF);
+
+static AVMutex trace_lock = AV_MUTEX_INITIALIZER;
+static TraceRing **rings;
+static int nb_rings;
+static int next_tid;
+
+#if HAVE_PTHREADS
+static pthread_key_t ring_key;
+static AVOnce ring_key_once = AV_ONCE_INIT;
+static int ring_key_ret;
+
+static void ring_release(void *opaque)
+{
+    TraceRing *ring = opaque;
+    int state = RING_ACTIVE;
+
+    /* a detached ring is not listed anymore and belongs to this thread */
+    if (!atomic_compare_exchange_strong(&ring->state, &state, RING_EXITED))
+        av_free(ring);
+}
+
+static void ring_key_init(void)
+{
+    ring_key_ret = AVERROR(pthread_key_create(&ring_key, ring_release));
+}
+
+/* the key lives as long as the process, as threads may still hold rings */
+static int create_ring_key(void)
+{
+    ff_thread_once(&ring_key_once, ring_key_init);
+    return ring_key_ret;
+}
+
+#define current_ring()      ((TraceRing *)pthread_getspecific(ring_key))
+#define set_current_ring(r) pthread_setspecific(ring_key, r)
+#else
+static TraceRing *cur_ring;
+
+static int create_ring_key(void)
+{
+    return 0;
+}
+
+#define current_ring()      cur_ring
+#define set_current_ring(r) (cur_ring = (r))
+#endif
+
+/* Return the ring of the calling thread, or NULL if it has none. A ring
+ * detached by av_trace_flush() is freed here, its tid is kept in *tid. */
+static TraceRing *own_ring(int *tid)
+{
+    TraceRing *ring = current_ring();
+
+    if (ring && atomic_load_explicit(&ring->state, memory_order_acquire) == RING_DETACHED) {
+        *tid = ring->tid;
+        av_free(ring);
+        set_current_ring(NULL);
+        return NULL;
+    }
+    return ring;
+}
+
+static TraceRing *new_ring(int tid)
+{
+    TraceRing *ring = av_mallocz(sizeof(*ring));
+
+    if (!ring)
+        return NULL;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->state, RING_ACTIVE);
+    atomic_init(&ring->depth, 0);
+    atomic_init(&ring->skipped, 0);
+
+    ff_mutex_lock(&trace_lock);
+    /* av_trace_flush() may have released everything in the meantime */
+    if (atomic_load(&trace_state) != TRACE_ON ||
+        av_dynarray_add_nofree(&rings, &nb_rings, ring) < 0) {
+        av_freep(&ring);
+    } else {
+        ring->tid = tid ? tid : ++next_tid;
+        set_current_ring(ring);
+    }
+    ff_mutex_unlock(&trace_lock);
+
+    return ring;
+}
+
+static void record(TraceRing *ring, const char *category, const char *name)
+{
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    TraceEvent *ev = &ring->events[head & (RING_SIZE - 1)];
+
+    ev->ts       = av_gettime_relative();
+    ev->category = category;
+    ev->name     = name;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+int av_trace_start(void)
+{
+    int ret;
+
+    if (!TRACE_SUPPORTED)
+        return AVERROR(ENOSYS);
+
+    ret = create_ring_key();
+    if (ret < 0)
+        return ret;
+
+    ff_mutex_lock(&trace_lock);
+    atomic_store(&trace_state, TRACE_ON);
+    ff_mutex_unlock(&trace_lock);
+
+    return 0;
+}
+
+void av_trace_stop(void)
+{
+    ff_mutex_lock(&trace_lock);
+    if (atomic_load(&trace_state) == TRACE_ON)
+        atomic_store(&trace_state, TRACE_STOPPED);
+    ff_mutex_unlock(&trace_lock);
+}
+
+#define LOAD(count)         atomic_load_explicit(count, memory_order_relaxed)
+#define STORE(count, val)   atomic_store_explicit(count, val, memory_order_relaxed)
+
+void av_trace_begin(const char *category, const char *name)
+{
+    TraceRing *ring;
+    unsigned used, depth, skipped;
+    int tid = 0;
+    int state = atomic_load_explicit(&trace_state, memory_order_relaxed);
+
+    if (state == TRACE_OFF)
+        return;
+    if (!(ring = own_ring(&tid)) &&
+        (state != TRACE_ON || !(ring = new_ring(tid))))
+        return;
+
+    depth   = LOAD(&ring->depth);
+    skipped = LOAD(&ring->skipped);
+
+    /* with no span open on this thread, a span begun while tracing is
+     * stopped cannot be confused with a recorded one */
+    if (state != TRACE_ON) {
+        if (depth || skipped)
+            STORE(&ring->skipped, skipped + 1);
+        return;
+    }
+
+    /* keep room for closing every open span, so that a recorded begin
+     * always gets its end; nested spans of a dropped one are dropped too.
+     * depth is raised before the event is published, so av_trace_flush()
+     * never releases a ring after writing out its begin event. */
+    used = atomic_load_explicit(&ring->head, memory_order_relaxed) -
+           atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (skipped || RING_SIZE - used < depth + 2) {
+        STORE(&ring->skipped, skipped + 1);
+    } else {
+        STORE(&ring->depth, depth + 1);
+        record(ring, category, name ? name : "");
+    }
+}
+
+void av_trace_end(void)
+{
+    TraceRing *ring;
+    unsigned depth, skipped;
+    int tid = 0;
+
+    if (atomic_load_explicit(&trace_state, memory_order_relaxed) == TRACE_OFF)
+        return;
+    if (!(ring = own_ring(&tid)))
+        return;
+
+    depth   = LOAD(&ring->depth);
+    skipped = LOAD(&ring->skipped);
+    if (skipped) {
+        STORE(&ring->skipped, skipped - 1);
+    } else if (depth) {
+        /* published before depth drops, see av_trace_flush() */
+        record(ring, NULL, NULL);
+        atomic_store_explicit(&ring->depth, depth - 1, memory_order_release);
+    }
+}
+
+static void print_json_string(AVBPrint *bp, const char *str)
+{
+    av_bprint_chars(bp, '"', 1);
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\')
+            av_bprintf(bp, "\\%c", *str);
+        else if ((unsigned char)*str < ' ')
+            av_bprintf(bp, "\\u%04x", *str);
+        else
+            av_bprint_chars(bp, *str, 1);
+    }
+    av_bprint_chars(bp, '"', 1);
+}
+
+/* Write out the events recorded so far and return the new tail. */
+static unsigned drain_ring(AVBPrint *bp, TraceRing *ring, int *nb_events)
+{
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    for (; tail != head; tail++) {
+        const TraceEvent *ev = &ring->events[tail & (RING_SIZE - 1)];
+
+        av_bprintf(bp, "{\"ph\":\"%c\",\"ts\":%"PRId64",\"pid\":1,\"tid\":%d",
+                   ev->name ? 'B' : 'E', ev->ts, ring->tid);
+        if (ev->name) {
+            av_bprintf(bp, ",\"cat\":");
+            print_json_string(bp, ev->category ? ev->category : "");
+            av_bprintf(bp, ",\"name\":");
+            print_json_string(bp, ev->name);
+        }
+        av_bprintf(bp, "},\n");
+        (*nb_events)++;
+    }
+    atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+    return tail;
+}
+
+int av_trace_flush(AVBPrint *bp)
+{
+    int i, stopped, nb_events = 0;
+
+    ff_mutex_lock(&trace_lock);
+    stopped = atomic_load(&trace_state) != TRACE_ON;
+    for (i = 0; i < nb_rings; i++) {
+        TraceRing *ring = rings[i];
+        int state = atomic_load_explicit(&ring->state, memory_order_acquire);
+        unsigned tail = drain_ring(bp, ring, &nb_events);
+
+        /* The rings of exited threads are freed once drained. Once stopped,
+         * the rings with no span open are released too: the one of the
+         * calling thread right away, the others are detached and left to
+         * their thread. A span closed after the drain leaves its end event
+         * behind the tail, so the ring is kept until the next call. */
+        if (state != RING_EXITED) {
+            if (!stopped ||
+                atomic_load_explicit(&ring->depth, memory_order_acquire) ||
+                atomic_load_explicit(&ring->skipped, memory_order_relaxed) ||
+                atomic_load_explicit(&ring->head, memory_order_acquire) != tail)
+                continue;
+            state = RING_ACTIVE;
+            if (ring == current_ring())
+                set_current_ring(NULL);
+            else if (atomic_compare_exchange_strong(&ring->state, &state,
+                                                    RING_DETACHED))
+                ring = NULL;
+            else
+                continue;   /* exited meanwhile, drain it again next time */
+        }
+        av_free(ring);
+        rings[i--] = rings[--nb_rings];
+    }
+
+    if (stopped && !nb_rings) {
+        av_freep(&rings);
+        atomic_store(&trace_state, TRACE_OFF);
+    }
+    ff_mutex_unlock(&trace_lock);
+
+    return av_bprint_is_complete(bp) ? nb_events : AVERROR(ENOMEM);
+}
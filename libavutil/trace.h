@@ -0,0 +1,107 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * @ingroup lavu_trace
+ * Timing spans for finding where time goes in a running pipeline.
+ */
+
+#ifndef AVUTIL_TRACE_H
+#define AVUTIL_TRACE_H
+
+#include "bprint.h"
+
+/**
+ * @defgroup lavu_trace Tracing
+ * @ingroup lavu_misc
+ *
+ * Record begin/end spans from any thread and export them as Chrome trace
+ * events, which can be loaded into chrome://tracing or the Perfetto UI.
+ *
+ * The libraries open a span around avcodec_send_packet(),
+ * avcodec_receive_frame(), avcodec_send_frame(), avcodec_receive_packet(),
+ * each filter activation, av_interleaved_write_frame() and every protocol
+ * read or write. Applications can add their own spans with
+ * av_trace_begin() and av_trace_end().
+ *
+ * Every thread records into its own fixed size ring buffer without taking
+ * any lock, so av_trace_flush() must be called regularly to drain them;
+ * spans that do not fit are dropped. Every recorded begin event is paired
+ * with an end event, even if tracing is stopped in between. Once tracing
+ * is stopped and the buffers have been released, each call costs a single
+ * atomic load.
+ *
+ * @{
+ */
+
+/**
+ * Start recording spans.
+ *
+ * @return 0 on success, a negative AVERROR code on failure, in particular
+ *         AVERROR(ENOSYS) if lavu was built without pthreads support
+ */
+int av_trace_start(void);
+
+/**
+ * Stop recording spans. Spans already recorded can still be retrieved with
+ * av_trace_flush(), and the spans that are open still record their end when
+ * they are closed.
+ *
+ * Once the spans of a thread have all been closed, the next call to
+ * av_trace_flush() releases its buffer. The buffers of the calling thread
+ * and of exited threads are freed right away, other threads free theirs
+ * when they next call av_trace_begin() or av_trace_end(), or exit.
+ */
+void av_trace_stop(void);
+
+/**
+ * Open a span on the calling thread.
+ *
+ * @param category category of the span, e.g. the API function
+ * @param name     name of the span, e.g. the component doing the work
+ *
+ * Both strings are stored by reference and must stay valid until the span
+ * has been flushed, in practice they should be static strings.
+ */
+void av_trace_begin(const char *category, const char *name);
+
+/**
+ * Close the innermost span opened by av_trace_begin() on the calling thread.
+ */
+void av_trace_end(void);
+
+/**
+ * Move all the spans recorded so far out of the per-thread buffers.
+ *
+ * Each event is appended to bp as a Chrome trace event object followed by
+ * a comma and a newline, so that the output of consecutive calls can be
+ * concatenated into the body of a JSON array. This function may be called
+ * while other threads are recording. The buffers of threads that have
+ * exited are freed once drained.
+ *
+ * @return the number of events written, or a negative AVERROR code if bp
+ *         ran out of memory
+ */
+int av_trace_flush(AVBPrint *bp);
+
+/**
+ * @}
+ */
+
+#endif /* AVUTIL_TRACE_H */
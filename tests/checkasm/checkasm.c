@@ -116,6 +116,7 @@ static const struct {
     #if CONFIG_HEVC_DECODER
         { "hevc_add_res", checkasm_check_hevc_add_res },
         { "hevc_idct", checkasm_check_hevc_idct },
+        { "hevc_pel", checkasm_check_hevc_pel },
         { "hevc_sao", checkasm_check_hevc_sao },
     #endif
     #if CONFIG_HUFFYUV_DECODER
@@ -235,6 +236,18 @@ typedef struct CheckasmFunc {
     char name[1];
 } CheckasmFunc;
 
+enum BenchFormat {
+    BENCH_TEXT,
+    BENCH_CSV,
+    BENCH_JSON,
+};
+
+/* Benchmark result loaded from a previous --csv run */
+typedef struct CheckasmBaseline {
+    char *name;
+    int decicycles;
+} CheckasmBaseline;
+
 /* Internal state */
 static struct {
     CheckasmFunc *funcs;
@@ -253,6 +266,14 @@ static struct {
     int cpu_flag;
     const char *cpu_flag_name;
     const char *test_name;
+
+    /* benchmark output */
+    enum BenchFormat bench_format;
+    CheckasmBaseline *baseline;
+    int nb_baseline;
+    double threshold;
+    int num_benched;
+    int num_regressions;
 } state;
 
 /* PRNG state */
@@ -463,20 +484,118 @@ static int measure_nop_time(void)
     return nop_sum / 500;
 }
 
+static int cmp_baseline(const void *a, const void *b)
+{
+    return strcmp(((const CheckasmBaseline *)a)->name,
+                  ((const CheckasmBaseline *)b)->name);
+}
+
+/* Load the "function,cpu,cycles" lines written by a previous --csv run */
+static int load_baseline(const char *filename)
+{
+    char line[512];
+    FILE *f = fopen(filename, "r");
+
+    if (!f) {
+        fprintf(stderr, "checkasm: could not open baseline file %s\n", filename);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        CheckasmBaseline *b;
+        char *cpu = strchr(line, ',');
+        char *cycles = cpu ? strchr(cpu + 1, ',') : NULL;
+
+        if (!cycles || !av_isdigit(cycles[1]))
+            continue; /* header or malformed line */
+        *cpu = '_';
+        *cycles = 0;
+
+        if (!(state.nb_baseline & (state.nb_baseline - 1))) {
+            b = realloc(state.baseline, FFMAX(2 * state.nb_baseline, 1) * sizeof(*b));
+            if (!b)
+                break;
+            state.baseline = b;
+        }
+        b = &state.baseline[state.nb_baseline];
+        if (!(b->name = strdup(line)))
+            break;
+        b->decicycles = lrint(strtod(cycles + 1, NULL) * 10);
+        state.nb_baseline++;
+    }
+    fclose(f);
+
+    qsort(state.baseline, state.nb_baseline, sizeof(*state.baseline), cmp_baseline);
+    return 0;
+}
+
+static const CheckasmBaseline *find_baseline(const char *func, const char *cpu)
+{
+    CheckasmBaseline key;
+    char name[256];
+
+    if (!state.nb_baseline)
+        return NULL;
+    snprintf(name, sizeof(name), "%s_%s", func, cpu);
+    key.name = name;
+    return bsearch(&key, state.baseline, state.nb_baseline,
+                   sizeof(*state.baseline), cmp_baseline);
+}
+
+static void print_bench(const char *func, const char *cpu, int decicycles)
+{
+    const CheckasmBaseline *b = find_baseline(func, cpu);
+    double change = 0;
+
+    decicycles = FFMAX(decicycles, 0);
+    if (b && b->decicycles > 0) {
+        change = 100.0 * (decicycles - b->decicycles) / b->decicycles;
+        if (change > state.threshold)
+            state.num_regressions++;
+    }
+
+    switch (state.bench_format) {
+    case BENCH_CSV:
+        printf("%s,%s,%d.%d", func, cpu, decicycles/10, decicycles%10);
+        if (b)
+            printf(",%d.%d,%+.1f", b->decicycles/10, b->decicycles%10, change);
+        else if (state.nb_baseline)
+            printf(",,");
+        printf("\n");
+        break;
+    case BENCH_JSON:
+        printf("%s\n  { \"function\": \"%s\", \"cpu\": \"%s\", \"cycles\": %d.%d",
+               state.num_benched ? "," : "", func, cpu, decicycles/10, decicycles%10);
+        if (b)
+            printf(", \"baseline\": %d.%d, \"change\": %.1f",
+                   b->decicycles/10, b->decicycles%10, change);
+        printf(" }");
+        break;
+    default:
+        printf("%s_%s: %d.%d", func, cpu, decicycles/10, decicycles%10);
+        if (b)
+            printf(" (baseline %d.%d, %+.1f%%%s)", b->decicycles/10, b->decicycles%10,
+                   change, change > state.threshold ? ", slower" : "");
+        printf("\n");
+    }
+    state.num_benched++;
+}
+
 /* Print benchmark results */
 static void print_benchs(CheckasmFunc *f)
 {
     if (f) {
         print_benchs(f->child[0]);
 
-        /* Only print functions with at least one assembly version */
-        if (f->versions.cpu || f->versions.next) {
+        /* Only print functions with at least one assembly version, unless
+         * the output is meant for tracking results over time */
+        if (f->versions.cpu || f->versions.next || state.bench_format != BENCH_TEXT) {
             CheckasmFuncVersion *v = &f->versions;
             do {
                 CheckasmPerf *p = &v->perf;
                 if (p->iterations) {
                     int decicycles = (10*p->cycles/p->iterations - state.nop_time) / 4;
-                    printf("%s_%s: %d.%d\n", f->name, cpu_suffix(v->cpu), decicycles/10, decicycles%10);
+                    print_bench(f->name, cpu_suffix(v->cpu), decicycles);
                 }
             } while ((v = v->next));
         }
@@ -586,6 +705,12 @@ static void print_cpu_name(void)
     }
 }
 
+/* Keep stdout clean for the benchmark results when they are meant to be parsed */
+static FILE *bench_info_file(void)
+{
+    return state.bench_format == BENCH_TEXT ? stdout : stderr;
+}
+
 #if CONFIG_LINUX_PERF
 static int bench_init_linux(void)
 {
@@ -598,7 +723,7 @@ static int bench_init_linux(void)
         .exclude_hv     = 1,
     };
 
-    printf("benchmarking with Linux Perf Monitoring API\n");
+    fprintf(bench_info_file(), "benchmarking with Linux Perf Monitoring API\n");
 
     state.sysfd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
     if (state.sysfd == -1) {
@@ -612,7 +737,7 @@ static int bench_init_linux(void)
 static int bench_init_ffmpeg(void)
 {
 #ifdef AV_READ_TIME
-    printf("benchmarking with native FFmpeg timers\n");
+    fprintf(bench_info_file(), "benchmarking with native FFmpeg timers\n");
     return 0;
 #else
     fprintf(stderr, "checkasm: --bench is not supported on your system\n");
@@ -631,16 +756,22 @@ static int bench_init(void)
         return ret;
 
     state.nop_time = measure_nop_time();
-    printf("nop: %d.%d\n", state.nop_time/10, state.nop_time%10);
+    fprintf(bench_info_file(), "nop: %d.%d\n", state.nop_time/10, state.nop_time%10);
+    fprintf(bench_info_file(), "cycles per call, mean of all runs not discarded as outliers\n");
     return 0;
 }
 
 static void bench_uninit(void)
 {
+    int i;
+
 #if CONFIG_LINUX_PERF
     if (state.sysfd > 0)
         close(state.sysfd);
 #endif
+    for (i = 0; i < state.nb_baseline; i++)
+        free(state.baseline[i].name);
+    free(state.baseline);
 }
 
 int main(int argc, char *argv[])
@@ -658,15 +789,26 @@ int main(int argc, char *argv[])
         return 0;
     }
 
+    state.threshold = 10;
+
     while (argc > 1) {
         if (!strncmp(argv[1], "--bench", 7)) {
-            if (bench_init() < 0)
-                return 1;
             if (argv[1][7] == '=') {
                 state.bench_pattern = argv[1] + 8;
                 state.bench_pattern_len = strlen(state.bench_pattern);
             } else
                 state.bench_pattern = "";
+        } else if (!strcmp(argv[1], "--text")) {
+            state.bench_format = BENCH_TEXT;
+        } else if (!strcmp(argv[1], "--csv")) {
+            state.bench_format = BENCH_CSV;
+        } else if (!strcmp(argv[1], "--json")) {
+            state.bench_format = BENCH_JSON;
+        } else if (!strncmp(argv[1], "--baseline=", 11)) {
+            if (load_baseline(argv[1] + 11) < 0)
+                return 1;
+        } else if (!strncmp(argv[1], "--threshold=", 12)) {
+            state.threshold = strtod(argv[1] + 12, NULL);
         } else if (!strncmp(argv[1], "--test=", 7)) {
             state.test_name = argv[1] + 7;
         } else {
@@ -677,6 +819,9 @@ int main(int argc, char *argv[])
         argv++;
     }
 
+    if (state.bench_pattern && bench_init() < 0)
+        return 1;
+
     fprintf(stderr, "checkasm: using random seed %u\n", seed);
     av_lfg_init(&checkasm_lfg, seed);
 
@@ -690,7 +835,18 @@ int main(int argc, char *argv[])
     } else {
         fprintf(stderr, "checkasm: all %d tests passed\n", state.num_checked);
         if (state.bench_pattern) {
+            if (state.bench_format == BENCH_CSV)
+                printf("function,cpu,cycles%s\n", state.nb_baseline ? ",baseline,change" : "");
+            else if (state.bench_format == BENCH_JSON)
+                printf("[");
             print_benchs(state.funcs);
+            if (state.bench_format == BENCH_JSON)
+                printf("\n]\n");
+            if (state.num_regressions) {
+                fprintf(stderr, "checkasm: %d of %d functions are more than %g%% slower than the baseline\n",
+                        state.num_regressions, state.num_benched, state.threshold);
+                ret = 1;
+            }
         }
     }
 
@@ -57,6 +57,7 @@ void checkasm_check_h264pred(void);
 void checkasm_check_h264qpel(void);
 void checkasm_check_hevc_add_res(void);
 void checkasm_check_hevc_idct(void);
+void checkasm_check_hevc_pel(void);
 void checkasm_check_hevc_sao(void);
 void checkasm_check_huffyuvdsp(void);
 void checkasm_check_jpeg2000dsp(void);
@@ -242,8 +243,8 @@ typedef struct CheckasmPerf {
                 }\
             }\
             emms_c();\
-            perf->cycles += t;\
-            perf->iterations++;\
+            perf->cycles += tsum;\
+            perf->iterations += tcount;\
         }\
     } while (0)
 #else
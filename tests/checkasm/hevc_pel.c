@@ -0,0 +1,165 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/intreadwrite.h"
+
+#include "libavcodec/hevcdsp.h"
+
+#include "checkasm.h"
+
+static const int sizes[] = { 2, 4, 6, 8, 12, 16, 24, 32, 48, 64 };
+
+/* enough room around the block for the 8-tap filters and for the
+ * overreads of the SIMD versions on the narrow block sizes */
+#define SRC_STRIDE ((MAX_PB_SIZE + 16) * 2)
+#define SRC_OFFSET (4 * SRC_STRIDE + 8)
+#define SRC_SIZE   ((MAX_PB_SIZE + 16) * SRC_STRIDE)
+#define DST_STRIDE (MAX_PB_SIZE * 2)
+
+#define randomize_pixels(buf0, buf1, size, bit_depth)       \
+    do {                                                    \
+        int j;                                              \
+        for (j = 0; j < size; j += 2) {                     \
+            uint16_t r = rnd() & ((1 << bit_depth) - 1);    \
+            if (bit_depth > 8) {                            \
+                AV_WN16A(buf0 + j, r);                      \
+            } else {                                        \
+                buf0[j]     = r;                            \
+                buf0[j + 1] = rnd();                        \
+            }                                               \
+        }                                                   \
+        memcpy(buf1, buf0, size);                           \
+    } while (0)
+
+static void check_put(HEVCDSPContext *h, int bit_depth, int qpel)
+{
+    LOCAL_ALIGNED_32(uint8_t, src0, [SRC_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, src1, [SRC_SIZE]);
+    LOCAL_ALIGNED_32(int16_t, dst0, [MAX_PB_SIZE * MAX_PB_SIZE]);
+    LOCAL_ALIGNED_32(int16_t, dst1, [MAX_PB_SIZE * MAX_PB_SIZE]);
+    const char *type = qpel ? "qpel" : "epel";
+    int nb_filters   = qpel ? 3 : 7;
+    int i, j, k, y;
+
+    declare_func(void, int16_t *dst, uint8_t *src, ptrdiff_t srcstride,
+                 int height, intptr_t mx, intptr_t my, int width);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+        int width = sizes[i];
+        for (j = 0; j < 2; j++) {
+            for (k = 0; k < 2; k++) {
+                void (*func)(int16_t *, uint8_t *, ptrdiff_t, int, intptr_t, intptr_t, int) =
+                    qpel ? h->put_hevc_qpel[i][j][k] : h->put_hevc_epel[i][j][k];
+                intptr_t mx = k ? 1 + rnd() % nb_filters : 0;
+                intptr_t my = j ? 1 + rnd() % nb_filters : 0;
+
+                if (check_func(func, "put_hevc_%s%s%s%d_%d", type,
+                               k ? "_h" : "", j ? "_v" : "", width, bit_depth)) {
+                    randomize_pixels(src0, src1, SRC_SIZE, bit_depth);
+                    memset(dst0, 0, MAX_PB_SIZE * MAX_PB_SIZE * sizeof(*dst0));
+                    memset(dst1, 0, MAX_PB_SIZE * MAX_PB_SIZE * sizeof(*dst1));
+                    call_ref(dst0, src0 + SRC_OFFSET, SRC_STRIDE, width, mx, my, width);
+                    call_new(dst1, src1 + SRC_OFFSET, SRC_STRIDE, width, mx, my, width);
+                    for (y = 0; y < width; y++)
+                        if (memcmp(dst0 + y * MAX_PB_SIZE, dst1 + y * MAX_PB_SIZE,
+                                   width * sizeof(*dst0)))
+                            fail();
+                    bench_new(dst1, src1 + SRC_OFFSET, SRC_STRIDE, width, mx, my, width);
+                }
+            }
+        }
+    }
+}
+
+static void check_put_bi(HEVCDSPContext *h, int bit_depth, int qpel)
+{
+    LOCAL_ALIGNED_32(uint8_t, src0, [SRC_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, src1, [SRC_SIZE]);
+    LOCAL_ALIGNED_32(int16_t, ref0, [MAX_PB_SIZE * MAX_PB_SIZE]);
+    LOCAL_ALIGNED_32(int16_t, ref1, [MAX_PB_SIZE * MAX_PB_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [MAX_PB_SIZE * DST_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [MAX_PB_SIZE * DST_STRIDE]);
+    const char *type = qpel ? "qpel" : "epel";
+    int nb_filters   = qpel ? 3 : 7;
+    int pixel_size   = bit_depth > 8 ? 2 : 1;
+    int i, j, k, y;
+
+    declare_func(void, uint8_t *dst, ptrdiff_t dststride, uint8_t *src, ptrdiff_t srcstride,
+                 int16_t *src2, int height, intptr_t mx, intptr_t my, int width);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+        int width = sizes[i];
+        for (j = 0; j < 2; j++) {
+            for (k = 0; k < 2; k++) {
+                void (*func)(uint8_t *, ptrdiff_t, uint8_t *, ptrdiff_t, int16_t *, int, intptr_t, intptr_t, int) =
+                    qpel ? h->put_hevc_qpel_bi[i][j][k] : h->put_hevc_epel_bi[i][j][k];
+                intptr_t mx = k ? 1 + rnd() % nb_filters : 0;
+                intptr_t my = j ? 1 + rnd() % nb_filters : 0;
+
+                if (check_func(func, "put_hevc_%s_bi%s%s%d_%d", type,
+                               k ? "_h" : "", j ? "_v" : "", width, bit_depth)) {
+                    randomize_pixels(src0, src1, SRC_SIZE, bit_depth);
+                    /* keep the second prediction in a range where the
+                     * saturating adds of the SIMD versions cannot clip */
+                    for (y = 0; y < MAX_PB_SIZE * MAX_PB_SIZE; y++)
+                        ref0[y] = rnd() & ((1 << bit_depth) - 1);
+                    memcpy(ref1, ref0, MAX_PB_SIZE * MAX_PB_SIZE * sizeof(*ref0));
+                    memset(dst0, 0, MAX_PB_SIZE * DST_STRIDE);
+                    memset(dst1, 0, MAX_PB_SIZE * DST_STRIDE);
+                    call_ref(dst0, DST_STRIDE, src0 + SRC_OFFSET, SRC_STRIDE,
+                             ref0, width, mx, my, width);
+                    call_new(dst1, DST_STRIDE, src1 + SRC_OFFSET, SRC_STRIDE,
+                             ref1, width, mx, my, width);
+                    for (y = 0; y < width; y++)
+                        if (memcmp(dst0 + y * DST_STRIDE, dst1 + y * DST_STRIDE,
+                                   width * pixel_size))
+                            fail();
+                    bench_new(dst1, DST_STRIDE, src1 + SRC_OFFSET, SRC_STRIDE,
+                              ref1, width, mx, my, width);
+                }
+            }
+        }
+    }
+}
+
+void checkasm_check_hevc_pel(void)
+{
+    int bit_depth, qpel;
+
+    for (qpel = 0; qpel <= 1; qpel++) {
+        for (bit_depth = 8; bit_depth <= 12; bit_depth += 2) {
+            HEVCDSPContext h;
+
+            ff_hevc_dsp_init(&h, bit_depth);
+            check_put(&h, bit_depth, qpel);
+        }
+        report(qpel ? "qpel" : "epel");
+    }
+
+    for (qpel = 0; qpel <= 1; qpel++) {
+        for (bit_depth = 8; bit_depth <= 12; bit_depth += 2) {
+            HEVCDSPContext h;
+
+            ff_hevc_dsp_init(&h, bit_depth);
+            check_put_bi(&h, bit_depth, qpel);
+        }
+        report(qpel ? "qpel_bi" : "epel_bi");
+    }
+}
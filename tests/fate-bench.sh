@@ -0,0 +1,150 @@
+#! /bin/sh
+#
+# Run representative decode, filter, encode and remux pipelines on the
+# generated test samples and record throughput, codec time per frame and
+# peak memory use, optionally comparing them against an earlier run.
+#
+# usage: fate-bench.sh target_exec target_path output [baseline [threshold [threads]]]
+
+export LC_ALL=C
+
+target_exec=$1
+target_path=$2
+output=$3
+baseline=$4
+threshold=${5:-10}
+threads=${6:-1}
+
+datadir="tests/data/bench"
+vsynth="tests/data/vsynth1.yuv"
+asynth="tests/data/asynth1.sw"
+# vsynth1 is only 50 frames and asynth1 6 seconds long, loop them to get
+# stable timings
+loops=19
+
+failed=0
+
+mkdir -p "$datadir" || exit 1
+
+ffmpeg(){
+    $target_exec $target_path/ffmpeg${PROGSUF} -nostdin -nostats -y "$@"
+}
+
+raw_video="-stream_loop $loops -f rawvideo -pix_fmt yuv420p -s 352x288 -framerate 25 -i $target_path/$vsynth"
+raw_audio="-stream_loop $((loops * 5)) -f s16le -ar 44100 -ac 2 -i $target_path/$asynth"
+
+# Compressed inputs for the decoding and remuxing pipelines
+prepare(){
+    name=$1
+    shift
+    test -f "$datadir/$name" && return
+    if ! ffmpeg -v error $raw_video "$@" -threads $threads "$target_path/$datadir/$name"; then
+        echo "$name: could not be created" >&2
+        rm -f "$datadir/$name"
+        failed=$((failed + 1))
+    fi
+}
+
+# Print "frames,fps,rtime,utime,stime,maxrss,p50,p90,p99,max" from the
+# -benchmark and -benchmark_all output of one run. The per-frame figures
+# are the decoding and encoding time (in ms) spent on each frame, i.e. the
+# real time of the bench lines up to and including its encode_* lines;
+# time spent in filters and muxing is not included.
+parse(){
+    awk '
+    /^bench: .* real / {
+        if ($8 ~ /^encode_/) {
+            enc = 1
+        } else if (enc) {
+            lat[n++] = t; t = enc = 0
+        }
+        t += $6
+    }
+    /^bench: utime=/ {
+        split($2, u, "="); split($3, s, "="); split($4, r, "=")
+        utime = u[2] + 0; stime = s[2] + 0; rtime = r[2] + 0
+    }
+    /^bench: maxrss=/ { split($2, m, "="); maxrss = m[2] + 0 }
+    /^frame=/ { sub(/^frame= */, ""); frames = $1 + 0 }
+    END {
+        if (enc)
+            lat[n++] = t
+        if (!frames)
+            frames = n
+        if (n) {
+            for (i = 1; i < n; i++)
+                for (j = i; j > 0 && lat[j - 1] > lat[j]; j--) {
+                    v = lat[j]; lat[j] = lat[j - 1]; lat[j - 1] = v
+                }
+            p50 = lat[int(n * 0.50)] / 1000; p90 = lat[int(n * 0.90)] / 1000
+            p99 = lat[int(n * 0.99)] / 1000; max = lat[n - 1] / 1000
+        }
+        fps = rtime > 0 ? frames / rtime : 0
+        printf "%d,%.1f,%.3f,%.3f,%.3f,%d,%.3f,%.3f,%.3f,%.3f\n", frames, fps,
+               rtime, utime, stime, maxrss, p50, p90, p99, max
+    }'
+}
+
+results="$output.tmp"
+echo "pipeline,frames,fps,rtime,utime,stime,maxrss_kb,frame_ms_p50,frame_ms_p90,frame_ms_p99,frame_ms_max" > "$results"
+
+bench(){
+    name=$1
+    shift
+    log="$datadir/$name.log"
+    if ffmpeg -benchmark -benchmark_all -threads $threads "$@" > "$log" 2>&1; then
+        echo "$name,$(parse < "$log")" >> "$results"
+    else
+        echo "$name: failed, see $log" >&2
+        failed=$((failed + 1))
+    fi
+}
+
+prepare mpeg4.nut  -c:v mpeg4 -qscale:v 3
+prepare mjpeg.nut  -c:v mjpeg -qscale:v 3
+prepare ffv1.nut   -c:v ffv1
+
+bench decode-mpeg4        -i "$target_path/$datadir/mpeg4.nut" -f null -
+bench decode-mjpeg        -i "$target_path/$datadir/mjpeg.nut" -f null -
+bench decode-ffv1         -i "$target_path/$datadir/ffv1.nut" -f null -
+bench encode-mpeg4        $raw_video -c:v mpeg4 -qscale:v 3 -f null -
+bench encode-mjpeg        $raw_video -c:v mjpeg -qscale:v 3 -f null -
+bench encode-ffv1         $raw_video -c:v ffv1 -f null -
+bench filter-scale        $raw_video -vf scale=1280:720:flags=bicubic -c:v rawvideo -f null -
+bench filter-chain        $raw_video -vf "hflip,pad=384:320:16:16,crop=352:288,format=yuv422p" \
+                          -c:v rawvideo -f null -
+bench transcode-mpeg4     -i "$target_path/$datadir/mjpeg.nut" -vf scale=704:576 -c:v mpeg4 -qscale:v 3 -f null -
+bench remux-matroska      -i "$target_path/$datadir/mpeg4.nut" -c copy -f matroska "$target_path/$datadir/remux.mkv"
+bench encode-mp2          $raw_audio -c:a mp2 -b:a 192k -f null -
+bench encode-flac         $raw_audio -c:a flac -f null -
+bench filter-aresample    $raw_audio -af aresample=48000,volume=0.5 -c:a pcm_s16le -f null -
+
+mv "$results" "$output"
+cat "$output"
+
+if [ $failed -gt 0 ]; then
+    echo "$failed of the benchmark runs failed" >&2
+fi
+
+test -n "$baseline" || exit $((failed > 0))
+
+# Flag pipelines whose throughput dropped by more than threshold percent
+awk -F, -v threshold="$threshold" '
+    NR == FNR { if (FNR > 1) fps[$1] = $3; next }
+    FNR > 1 && ($1 in fps) && fps[$1] > 0 {
+        change = 100 * ($3 - fps[$1]) / fps[$1]
+        mark = ""
+        if (-change > threshold) {
+            mark = "  slower"
+            slower++
+        }
+        printf "%-24s %10.1f fps %10.1f fps %+7.1f%%%s\n", $1, fps[$1], $3, change, mark
+    }
+    END {
+        if (slower) {
+            printf "%d pipelines are more than %g%% slower than the baseline\n", slower, threshold
+            exit 1
+        }
+    }' "$baseline" "$output" || exit 1
+
+exit $((failed > 0))
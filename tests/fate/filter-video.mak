@@ -431,6 +431,10 @@ fate-filter-concat: CMD = framecrc -filter_complex_script $(TARGET_PATH)/tests/d
 FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FPS_FILTER MPDECIMATE_FILTER) += fate-filter-mpdecimate
 fate-filter-mpdecimate: CMD = framecrc -lavfi testsrc2=r=2:d=10,fps=3,mpdecimate -r 3 -pix_fmt yuv420p
 
+FATE_FILTER-$(CONFIG_DNN) += fate-filter-dnn-native
+fate-filter-dnn-native: libavfilter/tests/dnn_native$(EXESUF)
+fate-filter-dnn-native: CMD = run libavfilter/tests/dnn_native
+
 FATE_FILTER-$(call ALLYES, FPS_FILTER TESTSRC2_FILTER) += fate-filter-fps-up fate-filter-fps-up-round-down fate-filter-fps-up-round-up fate-filter-fps-down fate-filter-fps-down-round-down fate-filter-fps-down-round-up fate-filter-fps-down-eof-pass fate-filter-fps-start-drop fate-filter-fps-start-fill
 fate-filter-fps-up: CMD = framecrc -lavfi testsrc2=r=3:d=2,fps=7
 fate-filter-fps-up-round-down: CMD = framecrc -lavfi testsrc2=r=3:d=2,fps=7:round=down
@@ -480,6 +484,11 @@ FATE_FILTER_VSYNTH-$(CONFIG_SCALE2REF_FILTER) += fate-filter-scale2ref_keep_aspe
 fate-filter-scale2ref_keep_aspect: tests/data/filtergraphs/scale2ref_keep_aspect
 fate-filter-scale2ref_keep_aspect: CMD = framemd5 -frames:v 5 -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/scale2ref_keep_aspect -map "[main]"
 
+# the threads=1 and threaded outputs of each pair must be identical
+FATE_FILTER_VSYNTH-$(call ALLYES, SPLIT_FILTER SCALE_FILTER FORMAT_FILTER) += fate-filter-scale-threads
+fate-filter-scale-threads: tests/data/vsynth1.yuv
+fate-filter-scale-threads: CMD = framecrc -flags bitexact -s 352x288 -pix_fmt yuv420p -i tests/data/vsynth1.yuv -filter_complex_threads 4 -sws_flags +bitexact -filter_complex "split=4[a][b][c][d];[a]scale=w=704:h=288:threads=1[w];[b]scale=w=704:h=288[x];[c]scale=w=176:h=288:threads=1,format=yuv420p10le[y];[d]scale=w=176:h=288,format=yuv420p10le[z]" -map "[w]" -map "[x]" -map "[y]" -map "[z]" -frames:v 5
+
 FATE_FILTER_VSYNTH-$(CONFIG_SCALE_FILTER) += fate-filter-scalechroma
 fate-filter-scalechroma: tests/data/vsynth1.yuv
 fate-filter-scalechroma: CMD = framecrc -flags bitexact -s 352x288 -pix_fmt yuv444p -i tests/data/vsynth1.yuv -pix_fmt yuv420p -sws_flags +bitexact -vf scale=out_v_chr_pos=33:out_h_chr_pos=151